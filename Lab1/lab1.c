@@ -16,12 +16,7 @@ int load_reviews(const char *filename, Review reviews[], int *count) {
     }
 
     *count = 0;
-    while (*count < MAX_REVIEWS &&
-           fscanf(file, "%[^,], %[^,], %[^,], %[^\n]\n", 
-                  reviews[*count].username, 
-                  reviews[*count].productname, 
-                  reviews[*count].reviewtext, 
-                  reviews[*count].attachment) == 4) {
+    while (*count < MAX_REVIEWS && read_review(file, &reviews[*count])) {
         (*count)++;
     }
 
@@ -79,5 +74,65 @@ int main() {
         }
     }
 
+    // Columnar configuration
+    if (!load_reviews("reviews.txt", reviews, &review_count)) {
+        return 1;
+    }
+
+    static ReviewBatch batch;
+    batch_from_reviews(&batch, reviews, review_count);
+
+    int (*pipeline2[])(ReviewBatch *) = {
+        batch_filter_non_buyers,
+        batch_filter_propaganda,
+        batch_filter_profanities,
+        batch_remove_competition_links,
+        batch_transform_resize_pictures,
+        batch_transform_analyze_sentiment
+    };
+
+    process_batch(&batch, pipeline2, 6);
+    review_count = batch_gather(&batch, reviews);
+
+    // Print results
+    printf("\nColumnar Processed Reviews:\n");
+    for (int i = 0; i < review_count; i++) {
+        printf("%s, %s, %s, %s\n", 
+               reviews[i].username, 
+               reviews[i].productname, 
+               reviews[i].reviewtext, 
+               reviews[i].attachment);
+    }
+
+    // Stage-pipelined configuration: one thread per stage, two for sentiment analysis.
+    // The reader stage parses the file itself, only as fast as the stages keep up.
+    FILE *input = fopen("reviews.txt", "r");
+    if (!input) {
+        perror("Error opening file");
+        return 1;
+    }
+
+    int replicas[] = {1, 1, 1, 1, 1, 2};
+    StageReport reports[6];
+
+    review_count = MAX_REVIEWS;
+    int status = process_reviews_pipelined(input, reviews, &review_count, pipeline1, replicas, 6, reports);
+    fclose(input);
+    if (status != 0) {
+        printf("Pipeline configuration is not supported\n");
+        return 1;
+    }
+
+    // Print results
+    printf("\nPipelined Processed Reviews:\n");
+    for (int i = 0; i < review_count; i++) {
+        printf("%s, %s, %s, %s\n", 
+               reviews[i].username, 
+               reviews[i].productname, 
+               reviews[i].reviewtext, 
+               reviews[i].attachment);
+    }
+    print_stage_reports(reports, 6);
+
     return 0;
 }
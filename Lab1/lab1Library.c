@@ -48,6 +48,15 @@ void analyze_sentiment(char *text) {
     strcat(text, (upper > lower) ? "+" : (lower > upper) ? "-" : "=");
 }
 
+// Parse the next "username, product, text, attachment" line; returns 0 at end of input.
+int read_review(FILE *file, Review *review) {
+    return fscanf(file, "%[^,], %[^,], %[^,], %[^\n]\n",
+                  review->username,
+                  review->productname,
+                  review->reviewtext,
+                  review->attachment) == 4;
+}
+
 void process_reviews(Review reviews[], int *count, int (*filters[])(Review *, int *), int num_filters) {
     for (int i = 0; i < num_filters; i++) {
         filters[i](reviews, count);
@@ -146,3 +155,417 @@ void process_blackboard(Blackboard *bb) {
         }
     }
 }
+
+static void column_reset(Column *col) {
+    col->offsets[0] = 0;
+}
+
+static void column_append(Column *col, int row, const char *value) {
+    int start = col->offsets[row];
+    int len = strlen(value) + 1;
+    memcpy(col->data + start, value, len);
+    memset(col->data + start + len, 0, COLUMN_SLACK);
+    col->offsets[row + 1] = start + len + COLUMN_SLACK;
+}
+
+static char *column_value(Column *col, int row) {
+    return col->data + col->offsets[row];
+}
+
+void batch_from_reviews(ReviewBatch *batch, const Review reviews[], int count) {
+    column_reset(&batch->username);
+    column_reset(&batch->productname);
+    column_reset(&batch->reviewtext);
+    column_reset(&batch->attachment);
+
+    for (int i = 0; i < count; i++) {
+        column_append(&batch->username, i, reviews[i].username);
+        column_append(&batch->productname, i, reviews[i].productname);
+        column_append(&batch->reviewtext, i, reviews[i].reviewtext);
+        column_append(&batch->attachment, i, reviews[i].attachment);
+        batch->selection[i] = i;
+    }
+    batch->count = count;
+    batch->selected = count;
+}
+
+int batch_gather(const ReviewBatch *batch, Review reviews[]) {
+    for (int i = 0; i < batch->selected; i++) {
+        int row = batch->selection[i];
+        strcpy(reviews[i].username, batch->username.data + batch->username.offsets[row]);
+        strcpy(reviews[i].productname, batch->productname.data + batch->productname.offsets[row]);
+        strcpy(reviews[i].reviewtext, batch->reviewtext.data + batch->reviewtext.offsets[row]);
+        strcpy(reviews[i].attachment, batch->attachment.data + batch->attachment.offsets[row]);
+    }
+    return batch->selected;
+}
+
+void process_batch(ReviewBatch *batch, int (*filters[])(ReviewBatch *), int num_filters) {
+    for (int i = 0; i < num_filters; i++) {
+        filters[i](batch);
+    }
+}
+
+int batch_filter_non_buyers(ReviewBatch *batch) {
+    int j = 0;
+    for (int i = 0; i < batch->selected; i++) {
+        int row = batch->selection[i];
+        if (is_buyer(column_value(&batch->username, row), column_value(&batch->productname, row))) {
+            batch->selection[j++] = row;
+        }
+    }
+    batch->selected = j;
+    return 0;
+}
+
+int batch_filter_profanities(ReviewBatch *batch) {
+    int j = 0;
+    for (int i = 0; i < batch->selected; i++) {
+        int row = batch->selection[i];
+        if (!contains_profanity(column_value(&batch->reviewtext, row))) {
+            batch->selection[j++] = row;
+        }
+    }
+    batch->selected = j;
+    return 0;
+}
+
+int batch_filter_propaganda(ReviewBatch *batch) {
+    int j = 0;
+    for (int i = 0; i < batch->selected; i++) {
+        int row = batch->selection[i];
+        if (!contains_political_propaganda(column_value(&batch->reviewtext, row))) {
+            batch->selection[j++] = row;
+        }
+    }
+    batch->selected = j;
+    return 0;
+}
+
+int batch_remove_competition_links(ReviewBatch *batch) {
+    for (int i = 0; i < batch->selected; i++) {
+        remove_competitor_links(column_value(&batch->reviewtext, batch->selection[i]));
+    }
+    return 0;
+}
+
+int batch_transform_resize_pictures(ReviewBatch *batch) {
+    for (int i = 0; i < batch->selected; i++) {
+        resize_picture(column_value(&batch->attachment, batch->selection[i]));
+    }
+    return 0;
+}
+
+// Appends into the COLUMN_SLACK byte of each value; values whose slack is already
+// used (the batch was analyzed before) are skipped instead of overrunning the next row.
+int batch_transform_analyze_sentiment(ReviewBatch *batch) {
+    for (int i = 0; i < batch->selected; i++) {
+        int row = batch->selection[i];
+        char *text = column_value(&batch->reviewtext, row);
+        int room = batch->reviewtext.offsets[row + 1] - batch->reviewtext.offsets[row];
+        if ((int)strlen(text) + 2 <= room) {
+            analyze_sentiment(text);
+        }
+    }
+    return 0;
+}
+
+// Per-record kernels used by the stage pipeline; return 0 to drop the record.
+static int keep_buyer(Review *review) {
+    return is_buyer(review->username, review->productname);
+}
+
+static int keep_without_profanity(Review *review) {
+    return !contains_profanity(review->reviewtext);
+}
+
+static int keep_without_propaganda(Review *review) {
+    return !contains_political_propaganda(review->reviewtext);
+}
+
+static int apply_remove_links(Review *review) {
+    remove_competitor_links(review->reviewtext);
+    return 1;
+}
+
+static int apply_resize_picture(Review *review) {
+    resize_picture(review->attachment);
+    return 1;
+}
+
+static int apply_analyze_sentiment(Review *review) {
+    analyze_sentiment(review->reviewtext);
+    return 1;
+}
+
+static const struct {
+    int (*filter)(Review *, int *);
+    int (*kernel)(Review *);
+    const char *name;
+} stage_kernels[] = {
+    {filter_non_buyers, keep_buyer, "filter_non_buyers"},
+    {filter_profanities, keep_without_profanity, "filter_profanities"},
+    {filter_propaganda, keep_without_propaganda, "filter_propaganda"},
+    {remove_competition_links, apply_remove_links, "remove_competition_links"},
+    {transform_resize_pictures, apply_resize_picture, "transform_resize_pictures"},
+    {transform_analyze_sentiment, apply_analyze_sentiment, "transform_analyze_sentiment"},
+    {NULL, NULL, NULL} // End marker
+};
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Both return -1 instead of waiting once the pipeline is aborted
+static int ring_push(SpscRing *ring, const HandleBatch *batch, _Atomic int *aborted) {
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    while (tail - atomic_load_explicit(&ring->head, memory_order_acquire) == PIPELINE_RING_CAPACITY) {
+        if (atomic_load_explicit(aborted, memory_order_relaxed)) {
+            return -1;
+        }
+        sched_yield(); // backpressure: wait for the consumer
+    }
+    ring->slots[tail & (PIPELINE_RING_CAPACITY - 1)] = *batch;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+static int ring_pop(SpscRing *ring, HandleBatch *batch, _Atomic int *aborted) {
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while (atomic_load_explicit(&ring->tail, memory_order_acquire) == head) {
+        if (atomic_load_explicit(aborted, memory_order_relaxed)) {
+            return -1;
+        }
+        sched_yield();
+    }
+    *batch = ring->slots[head & (PIPELINE_RING_CAPACITY - 1)];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return 0;
+}
+
+// Boundary b sits in front of stage b (boundary num_stages feeds the collector).
+// Batch n travels from producer n % producers to consumer n % consumers, so every
+// ring has one producer and one consumer and batches stay in input order.
+// Batch n owns pool block n % PIPELINE_POOL_BATCHES until the collector has copied it out.
+typedef struct {
+    FILE *input;
+    Review pool[PIPELINE_POOL_BATCHES * PIPELINE_BATCH_SIZE];
+    _Atomic int collected; // batches the collector is done with; frees their pool blocks
+    int num_stages;
+    int (*kernels[MAX_STAGES])(Review *);
+    int replicas[MAX_STAGES];
+    SpscRing rings[MAX_STAGES + 1][MAX_STAGE_REPLICAS][MAX_STAGE_REPLICAS];
+    long long busy_ns[MAX_STAGES][MAX_STAGE_REPLICAS];
+    long records_in[MAX_STAGES][MAX_STAGE_REPLICAS];
+    long records_out[MAX_STAGES][MAX_STAGE_REPLICAS];
+    _Atomic int aborted; // set when the pipeline could not be fully started
+} Pipeline;
+
+typedef struct {
+    Pipeline *pipeline;
+    int stage;
+    int replica;
+} StageWorker;
+
+static int boundary_producers(const Pipeline *p, int boundary) {
+    return boundary == 0 ? 1 : p->replicas[boundary - 1];
+}
+
+static int boundary_consumers(const Pipeline *p, int boundary) {
+    return boundary == p->num_stages ? 1 : p->replicas[boundary];
+}
+
+// Parses records as the pipeline has room for them, so full rings or a full pool
+// stop the parsing instead of letting it run ahead of the stages.
+static void *pipeline_reader(void *arg) {
+    Pipeline *p = arg;
+    int consumers = boundary_consumers(p, 0);
+    HandleBatch batch;
+
+    for (int n = 0; ; n++) {
+        while (n - atomic_load_explicit(&p->collected, memory_order_acquire) >= PIPELINE_POOL_BATCHES) {
+            if (atomic_load_explicit(&p->aborted, memory_order_relaxed)) {
+                return NULL;
+            }
+            sched_yield(); // backpressure: wait for the collector to free a pool block
+        }
+
+        int block = (n % PIPELINE_POOL_BATCHES) * PIPELINE_BATCH_SIZE;
+        batch.sequence = n;
+        batch.count = 0;
+        while (batch.count < PIPELINE_BATCH_SIZE && read_review(p->input, &p->pool[block + batch.count])) {
+            batch.handles[batch.count] = block + batch.count;
+            batch.count++;
+        }
+        if (batch.count == 0) {
+            break;
+        }
+        if (ring_push(&p->rings[0][0][n % consumers], &batch, &p->aborted) != 0) {
+            return NULL;
+        }
+        if (batch.count < PIPELINE_BATCH_SIZE) {
+            break;
+        }
+    }
+
+    batch.sequence = -1;
+    batch.count = 0;
+    for (int c = 0; c < consumers; c++) {
+        if (ring_push(&p->rings[0][0][c], &batch, &p->aborted) != 0) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+static void *pipeline_stage(void *arg) {
+    StageWorker *worker = arg;
+    Pipeline *p = worker->pipeline;
+    int s = worker->stage;
+    int j = worker->replica;
+    int producers = boundary_producers(p, s);
+    int consumers = boundary_consumers(p, s + 1);
+    HandleBatch batch;
+
+    for (int n = j; ; n += p->replicas[s]) {
+        if (ring_pop(&p->rings[s][n % producers][j], &batch, &p->aborted) != 0) {
+            return NULL;
+        }
+        if (batch.sequence < 0) {
+            for (int c = 0; c < consumers; c++) {
+                if (ring_push(&p->rings[s + 1][j][c], &batch, &p->aborted) != 0) {
+                    return NULL;
+                }
+            }
+            return NULL;
+        }
+
+        long long start = now_ns();
+        int kept = 0;
+        for (int i = 0; i < batch.count; i++) {
+            if (p->kernels[s](&p->pool[batch.handles[i]])) {
+                batch.handles[kept++] = batch.handles[i];
+            }
+        }
+        p->busy_ns[s][j] += now_ns() - start;
+        p->records_in[s][j] += batch.count;
+        p->records_out[s][j] += kept;
+        batch.count = kept;
+
+        if (ring_push(&p->rings[s + 1][j][n % consumers], &batch, &p->aborted) != 0) {
+            return NULL;
+        }
+    }
+}
+
+// Reads records from input until end of file; at most *count survivors are stored in reviews.
+int process_reviews_pipelined(FILE *input, Review reviews[], int *count, int (*filters[])(Review *, int *), const int replicas[], int num_filters, StageReport reports[]) {
+    if (num_filters < 1 || num_filters > MAX_STAGES) {
+        return -1;
+    }
+
+    Pipeline *p = calloc(1, sizeof(Pipeline));
+    if (!p) {
+        return -1;
+    }
+    p->input = input;
+    p->num_stages = num_filters;
+
+    int workers = 0;
+    for (int s = 0; s < num_filters; s++) {
+        int k = 0;
+        while (stage_kernels[k].filter != NULL && stage_kernels[k].filter != filters[s]) {
+            k++;
+        }
+        if (stage_kernels[k].filter == NULL || replicas[s] < 1 || replicas[s] > MAX_STAGE_REPLICAS) {
+            free(p);
+            return -1;
+        }
+        p->kernels[s] = stage_kernels[k].kernel;
+        p->replicas[s] = replicas[s];
+        reports[s].name = stage_kernels[k].name;
+        reports[s].replicas = replicas[s];
+        workers += replicas[s];
+    }
+
+    pthread_t reader;
+    pthread_t threads[MAX_STAGES * MAX_STAGE_REPLICAS];
+    StageWorker contexts[MAX_STAGES * MAX_STAGE_REPLICAS];
+    long long start = now_ns();
+
+    int t = 0;
+    int started = 1;
+    for (int s = 0; s < num_filters && started; s++) {
+        for (int j = 0; j < replicas[s] && started; j++) {
+            contexts[t].pipeline = p;
+            contexts[t].stage = s;
+            contexts[t].replica = j;
+            if (pthread_create(&threads[t], NULL, pipeline_stage, &contexts[t]) != 0) {
+                started = 0;
+            } else {
+                t++;
+            }
+        }
+    }
+    if (started && pthread_create(&reader, NULL, pipeline_reader, p) != 0) {
+        started = 0;
+    }
+    if (!started) {
+        // Stages already running are waiting on their rings; wake them and wait for them to exit
+        atomic_store_explicit(&p->aborted, 1, memory_order_relaxed);
+        for (int i = 0; i < t; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        free(p);
+        return -1;
+    }
+
+    // Collect surviving records in input order on the calling thread
+    int producers = boundary_producers(p, num_filters);
+    int capacity = *count;
+    int survivors = 0;
+    HandleBatch batch;
+    for (int n = 0; ; n++) {
+        ring_pop(&p->rings[num_filters][n % producers][0], &batch, &p->aborted);
+        if (batch.sequence < 0) {
+            break;
+        }
+        for (int i = 0; i < batch.count && survivors < capacity; i++) {
+            reviews[survivors++] = p->pool[batch.handles[i]];
+        }
+        // The batch's pool block can now be refilled by the reader
+        atomic_store_explicit(&p->collected, n + 1, memory_order_release);
+    }
+
+    pthread_join(reader, NULL);
+    for (int i = 0; i < workers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    long long wall = now_ns() - start;
+
+    for (int s = 0; s < num_filters; s++) {
+        long long busy = 0;
+        reports[s].records_in = 0;
+        reports[s].records_out = 0;
+        for (int j = 0; j < replicas[s]; j++) {
+            busy += p->busy_ns[s][j];
+            reports[s].records_in += p->records_in[s][j];
+            reports[s].records_out += p->records_out[s][j];
+        }
+        reports[s].utilization = wall > 0 ? (double)busy / ((double)wall * replicas[s]) : 0.0;
+    }
+
+    *count = survivors;
+    free(p);
+    return 0;
+}
+
+void print_stage_reports(const StageReport reports[], int num_stages) {
+    for (int s = 0; s < num_stages; s++) {
+        printf("%-28s x%d  in: %4ld  out: %4ld  utilization: %5.1f%%\n",
+               reports[s].name, reports[s].replicas, reports[s].records_in,
+               reports[s].records_out, reports[s].utilization * 100.0);
+    }
+}
@@ -2,8 +2,13 @@
 #define LAB1LIBRARY_H
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 
 #define MAX_LENGTH 256
 #define MAX_REVIEWS 100
@@ -21,17 +26,86 @@ typedef struct {
     int processed[MAX_REVIEWS];
 } Blackboard;
 
+// Columnar batch: one contiguous byte buffer per field, rows addressed by offsets.
+// Every value keeps COLUMN_SLACK spare bytes so in-place transforms can append a marker.
+#define COLUMN_SLACK 1
+#define COLUMN_CAPACITY (MAX_REVIEWS * (MAX_LENGTH + COLUMN_SLACK))
+
+typedef struct {
+    char data[COLUMN_CAPACITY];
+    int offsets[MAX_REVIEWS + 1];
+} Column;
+
+typedef struct {
+    Column username;
+    Column productname;
+    Column reviewtext;
+    Column attachment;
+    int count;
+    int selection[MAX_REVIEWS]; // rows still alive, in input order
+    int selected;
+} ReviewBatch;
+
+// Stage pipeline: a reader parses records into a bounded pool, and every stage runs on its
+// own thread(s), connected by bounded SPSC rings carrying batches of record handles
+// (indexes into the pool).
+#define PIPELINE_BATCH_SIZE 8
+#define PIPELINE_RING_CAPACITY 4 // power of two; a full ring blocks the producer
+#define PIPELINE_POOL_BATCHES 16 // batches parsed but not yet collected; a full pool blocks the reader
+#define MAX_STAGES 8
+#define MAX_STAGE_REPLICAS 4
+#define CACHE_LINE_SIZE 64
+
+typedef struct {
+    int sequence; // batch number in input order, -1 marks end of stream
+    int count;
+    int handles[PIPELINE_BATCH_SIZE];
+} HandleBatch;
+
+// head and tail are padded onto their own cache lines so the consumer and the
+// producer do not invalidate each other's line on every batch
+typedef struct {
+    HandleBatch slots[PIPELINE_RING_CAPACITY];
+    char pad0[CACHE_LINE_SIZE];
+    _Atomic unsigned head; // next slot the consumer reads
+    char pad1[CACHE_LINE_SIZE - sizeof(unsigned)];
+    _Atomic unsigned tail; // next slot the producer writes
+    char pad2[CACHE_LINE_SIZE - sizeof(unsigned)];
+} SpscRing;
+
+typedef struct {
+    const char *name;
+    int replicas;
+    long records_in;
+    long records_out;
+    double utilization; // busy time / (wall time * replicas)
+} StageReport;
+
 int is_buyer(const char *username, const char *productname);
 int contains_profanity(const char *text);
 int contains_political_propaganda(const char *text);
 void resize_picture(char *attachment);
 void remove_competitor_links(char *text);
 void analyze_sentiment(char *text);
+int read_review(FILE *file, Review *review);
 void process_reviews(Review reviews[], int *count, int (*filters[])(Review *, int *), int num_filters);
 int filter_non_buyers(Review *reviews, int *count);
 int filter_profanities(Review *reviews, int *count);
+int filter_propaganda(Review *reviews, int *count);
+int remove_competition_links(Review *reviews, int *count);
 int transform_resize_pictures(Review *reviews, int *count);
 int transform_analyze_sentiment(Review *reviews, int *count);
 void process_blackboard(Blackboard *bb);
+void batch_from_reviews(ReviewBatch *batch, const Review reviews[], int count);
+int batch_gather(const ReviewBatch *batch, Review reviews[]);
+void process_batch(ReviewBatch *batch, int (*filters[])(ReviewBatch *), int num_filters);
+int batch_filter_non_buyers(ReviewBatch *batch);
+int batch_filter_profanities(ReviewBatch *batch);
+int batch_filter_propaganda(ReviewBatch *batch);
+int batch_remove_competition_links(ReviewBatch *batch);
+int batch_transform_resize_pictures(ReviewBatch *batch);
+int batch_transform_analyze_sentiment(ReviewBatch *batch);
+int process_reviews_pipelined(FILE *input, Review reviews[], int *count, int (*filters[])(Review *, int *), const int replicas[], int num_filters, StageReport reports[]);
+void print_stage_reports(const StageReport reports[], int num_stages);
 
 #endif // LAB1LIBRARY_H
\ No newline at end of file
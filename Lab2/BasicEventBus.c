@@ -7,10 +7,27 @@
  * 2. News distribution from agencies to interested people
  */
 
+ #define _GNU_SOURCE           // usleep, syscall and shm_open under strict C modes
+ 
  #include <stdio.h>
  #include <stdlib.h>
  #include <string.h>
  #include <time.h>
+ #include <stdatomic.h>
+ 
+ #ifdef __linux__
+ #include <errno.h>
+ #include <fcntl.h>
+ #include <limits.h>
+ #include <sched.h>
+ #include <signal.h>
+ #include <stdint.h>
+ #include <unistd.h>
+ #include <linux/futex.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <sys/syscall.h>
+ #endif
  
  /* Maximum capacity constants */
  #define MAX_SUBSCRIBERS 100   // Maximum number of subscribers in the system
@@ -27,6 +44,55 @@
  #define MAX_NEWS_LENGTH 512   // Maximum length of news content
  #define MAX_DOMAIN_LENGTH 50  // Maximum length of news domain name
  
+ /* Priority lane constants */
+ #define PRIORITY_LANE_COUNT 3      // Number of priority lanes (critical, normal, bulk)
+ #define LANE_CAPACITY 64           // Maximum number of queued events per lane
+ #define STARVATION_LIMIT 8         // Times a waiting lane may be passed over before it is served
+ #define SENSOR_DEADLINE_US 500000  // Routine sensor readings older than this are dropped
+ 
+ /* News fan-out constants */
+ #define MAX_DOMAINS 64        // Maximum number of distinct news domains (one bit each in a domain mask)
+ #define INBOX_CAPACITY 32     // Maximum number of undelivered stories per person
+ #define INBOX_BATCH_SIZE 8    // Maximum number of stories delivered in one digest
+ 
+ /* Metrics constants */
+ #define MAX_TOPICS 32              // Maximum number of event types tracked by the metrics
+ #define MAX_METRIC_THREADS 16      // Maximum number of threads holding metric counters at the same time
+ #define METRIC_BUCKETS 16          // Handler time histogram buckets (powers of two, in microseconds)
+ #define THROTTLE_SKIP_EVENTS 4     // Events a throttled subscriber skips before it is tried again
+ 
+ /* Snapshot constants */
+ #define SNAPSHOT_MAGIC "DACSSNAP"          // First bytes of every snapshot file
+ #define SNAPSHOT_VERSION 2                 // Bumped whenever the snapshot layout changes
+ #define SNAPSHOT_PATH "eventbus.snap"      // Default snapshot file
+ #define JOURNAL_PATH "eventbus.journal"    // Default delta journal file
+ #define JOURNAL_MAGIC "DACSJRNL"           // First bytes of every journal file
+ #define JOURNAL_VERSION 1                  // Bumped whenever the journal layout changes
+ #define MAX_NAMED_HANDLERS 20              // Maximum number of handlers that can be saved by name
+ #define MAX_HANDLER_NAME_LENGTH 50         // Maximum length of a handler name
+ 
+ /* Conflation constants */
+ #define MAX_CONFLATED_SUBSCRIBERS 10  // Maximum number of subscribers using last-value conflation
+ #define CONFLATION_SLOTS 64           // Distinct (type, source) keys per conflating subscriber (power of two)
+ 
+ /* Shared-memory transport constants */
+ #define SHARED_BUS_NAME "/dacss_eventbus"  // Name of the shared memory object
+ #define SHARED_BUS_MAGIC 0x44414353u       // Marks a fully initialized shared bus
+ #define SHARED_BUS_VERSION 1               // Bumped whenever the SharedEventBus layout changes
+ #define SHARED_ATTACH_TIMEOUT_MS 2000      // Time to wait for another process to finish creating the bus
+ #define SHARED_ATTACH_RETRIES 100          // Attempts to attach while the bus is being removed
+ #define SHARED_RING_CAPACITY 256           // Number of event slots in the ring (power of two)
+ #define SHARED_PAYLOAD_SIZE 256            // Maximum size of an inline event payload
+ #define MAX_SHARED_SUBSCRIBERS 32          // Maximum number of subscribers across all processes
+ #define SHARED_SPIN_COUNT 1000             // Polls before a subscriber sleeps on the futex
+ #define SHARED_IDLE_TIMEOUT_MS 5000        // Idle time after which the demo display exits
+ 
+ /**
+  * Event data callback function pointer type definition
+  * Used to take and drop references to reference-counted event data
+  */
+ typedef void (*EventDataCallback)(void *);
+ 
  /**
   * Event structure - Core data structure for the pub-sub system
   * Contains the type of event, the actual data, and the source ID
@@ -35,6 +101,8 @@
      char type[MAX_TYPE_LENGTH];     // Type of the event (e.g., "Temperature", "Sports")
      void *data;                     // Pointer to the actual data (can be any type)
      char sourceId[MAX_ID_LENGTH];   // ID of the publisher that generated the event
+     EventDataCallback retain;       // Takes a reference when the bus keeps data after publishing (or NULL)
+     EventDataCallback release;      // Drops a reference taken with retain (or NULL)
  } Event;
  
  /**
@@ -43,6 +111,41 @@
   */
  typedef void (*EventHandler)(Event *);
  
+ /**
+  * Event priorities - Lower value means more urgent
+  * Each priority has its own lane in the EventBus
+  */
+ typedef enum EventPriority {
+     PRIORITY_CRITICAL = 0,  // Alarms (e.g., water level spikes)
+     PRIORITY_NORMAL = 1,    // Routine sensor readings
+     PRIORITY_BULK = 2       // Bulk traffic that can wait
+ } EventPriority;
+ 
+ /**
+  * QueuedEvent structure - An event waiting in a priority lane
+  */
+ typedef struct QueuedEvent {
+     Event event;                  // The event to deliver
+     long long enqueuedNs;         // Monotonic time when the event was queued
+     long long deadlineNs;         // Monotonic time after which the event is stale (0 = never)
+ } QueuedEvent;
+ 
+ /**
+  * PriorityLane structure - Bounded FIFO queue for one priority, with statistics
+  */
+ typedef struct PriorityLane {
+     QueuedEvent events[LANE_CAPACITY];  // Circular buffer of queued events
+     int head;                           // Index of the oldest queued event
+     int count;                          // Current queue depth
+     int maxDepth;                       // Highest queue depth seen
+     int passedOver;                     // Consecutive dispatches that served a higher lane instead
+     long dispatched;                    // Events delivered to subscribers
+     long expired;                       // Events dropped because their deadline passed
+     long rejected;                      // Events refused because the lane was full
+     long long totalLatencyNs;           // Sum of queueing latency of dispatched events
+     long long maxLatencyNs;             // Highest queueing latency of a dispatched event
+ } PriorityLane;
+ 
  /**
   * Subscriber structure - Represents an entity that can receive events
   * Contains subscriber ID, list of event types they're interested in, and handler function
@@ -52,14 +155,148 @@
      char eventTypes[MAX_EVENT_TYPES][MAX_TYPE_LENGTH]; // Array of event types this subscriber listens for
      int eventTypeCount;                               // Number of event types currently registered
      EventHandler handler;                             // Function to call when matching event is received
+     int conflationTable;                              // Index in conflationTables, or -1 for immediate delivery
+     int slowViolations;                               // Consecutive handler calls over the latency budget
+     int throttleRemaining;                            // Events still to skip while throttled
+     int flaggedSlow;                                  // Nonzero once the subscriber was found to be slow
+     int detached;                                     // Nonzero if the slow-consumer policy detached it
  } Subscriber;
  
+ /**
+  * Slow-consumer policies - What happens to a subscriber whose handler keeps exceeding its budget
+  */
+ typedef enum SlowConsumerPolicy {
+     SLOW_POLICY_FLAG = 0,      // Only mark the subscriber as slow
+     SLOW_POLICY_THROTTLE = 1,  // Drop the next THROTTLE_SKIP_EVENTS events for the subscriber
+     SLOW_POLICY_DETACH = 2     // Stop delivering to the subscriber until resetSlowConsumer
+ } SlowConsumerPolicy;
+ 
+ /**
+  * ThreadMetrics structure - Dispatch counters owned by one thread
+  * Only the owning thread adds to them; readers add up all threads. Every field is a
+  * relaxed atomic counter so concurrent reads and resets are well defined
+  */
+ typedef struct ThreadMetrics {
+     _Atomic long long delivered[MAX_SUBSCRIBERS];                  // Events handled per subscriber
+     _Atomic long long dropped[MAX_SUBSCRIBERS];                    // Events lost per subscriber (throttled or detached)
+     _Atomic long long handlerNs[MAX_SUBSCRIBERS];                  // Total handler time per subscriber
+     _Atomic long long maxHandlerNs[MAX_SUBSCRIBERS];               // Longest handler call per subscriber
+     _Atomic long long histogram[MAX_SUBSCRIBERS][METRIC_BUCKETS];  // Handler time histogram per subscriber
+     _Atomic long long topicPublished[MAX_TOPICS];                  // Events dispatched per topic
+     _Atomic long long topicDelivered[MAX_TOPICS];                  // Handler calls per topic
+     _Atomic long long topicDropped[MAX_TOPICS];                    // Events lost per topic
+ } ThreadMetrics;
+ 
+ /**
+  * SubscriberMetrics structure - Aggregated metrics of one subscriber
+  */
+ typedef struct SubscriberMetrics {
+     char id[MAX_ID_LENGTH];          // Subscriber ID
+     long delivered;                  // Events handled
+     long dropped;                    // Events lost because the subscriber was throttled or detached
+     long long totalHandlerNs;        // Total handler time
+     long long maxHandlerNs;          // Longest handler call
+     long histogram[METRIC_BUCKETS];  // Handler time histogram
+     int queueDepth;                  // Events waiting in the subscriber's conflation table
+     int flagged;                     // Subscriber was found to be slow
+     int throttled;                   // Subscriber is currently throttled
+     int detached;                    // Subscriber was detached by the slow-consumer policy
+ } SubscriberMetrics;
+ 
+ /**
+  * TopicMetrics structure - Aggregated metrics of one event type
+  */
+ typedef struct TopicMetrics {
+     char type[MAX_TYPE_LENGTH];  // Event type
+     long published;              // Events dispatched to subscribers
+     long delivered;              // Handler calls
+     long dropped;                // Events lost (expired, rejected, throttled or detached)
+     int queueDepth;              // Events waiting in the priority lanes
+ } TopicMetrics;
+ 
+ /**
+  * BusMetricsSnapshot structure - Point-in-time view of all dispatch metrics
+  */
+ typedef struct BusMetricsSnapshot {
+     SubscriberMetrics subscribers[MAX_SUBSCRIBERS];  // One entry per subscriber
+     int subscriberCount;                             // Number of subscriber entries
+     TopicMetrics topics[MAX_TOPICS];                 // One entry per topic
+     int topicCount;                                  // Number of topic entries
+ } BusMetricsSnapshot;
+ 
+ /**
+  * ConflationSlot structure - Newest pending event for one (type, sourceId) key
+  */
+ typedef struct ConflationSlot {
+     Event latest;     // Newest event received for this key
+     int topic;        // Metrics index of the key's event type (-1 if untracked)
+     int used;         // Nonzero once the slot is assigned to a key
+     int pending;      // Nonzero if latest has not been delivered yet
+ } ConflationSlot;
+ 
+ /**
+  * ConflationTable structure - Per-subscriber slot table for last-value conflation
+  * Keys are hashed with open addressing, so memory stays bounded by CONFLATION_SLOTS
+  */
+ typedef struct ConflationTable {
+     ConflationSlot slots[CONFLATION_SLOTS];  // Slot per distinct (type, sourceId) key
+     int pendingCount;                        // Number of slots holding an undelivered event
+     long conflated;                          // Events replaced by a newer one before delivery
+     long overflowed;                         // Events delivered immediately because the table was full
+ } ConflationTable;
+ 
+ #ifdef __linux__
+ /**
+  * SharedEventSlot structure - Fixed-layout event stored in the shared ring
+  * The payload is copied inline, since pointers are meaningless in another process
+  */
+ typedef struct SharedEventSlot {
+     _Atomic uint64_t sequence;                 // Sequence number + 1 once the event is written
+     char type[MAX_TYPE_LENGTH];                // Type of the event
+     char sourceId[MAX_ID_LENGTH];              // ID of the publisher that generated the event
+     uint32_t payloadSize;                      // Number of valid bytes in payload
+     unsigned char payload[SHARED_PAYLOAD_SIZE]; // Inline copy of the event data
+ } SharedEventSlot;
+ 
+ /**
+  * SharedSubscriber structure - Subscription visible to every attached process
+  * Each subscriber reads the ring at its own cursor
+  */
+ typedef struct SharedSubscriber {
+     _Atomic int active;                                // Nonzero while the subscriber is attached
+     pid_t pid;                                         // Process that owns the subscriber
+     char id[MAX_ID_LENGTH];                            // Unique identifier for the subscriber
+     char eventTypes[MAX_EVENT_TYPES][MAX_TYPE_LENGTH]; // Event types this subscriber listens for
+     _Atomic int eventTypeCount;                        // Number of event types, published after the type string
+     _Atomic uint64_t cursor;                           // Sequence number of the next event to read
+ } SharedSubscriber;
+ 
+ /**
+  * SharedEventBus structure - Memory-mapped multi-producer ring and subscriber table
+  * Publishers claim slots with a compare-and-swap on tail; subscribers sleep on the notify futex
+  */
+ typedef struct SharedEventBus {
+     _Atomic uint32_t magic;                            // SHARED_BUS_MAGIC once initialized
+     uint32_t version;                                  // SHARED_BUS_VERSION of the creating build
+     uint32_t layoutSize;                               // sizeof(SharedEventBus) in the creating build
+     _Atomic uint32_t attached;                         // Number of processes that have the bus mapped
+     _Atomic int tableLock;                             // Spinlock guarding the subscriber table
+     _Atomic uint32_t notify;                           // Futex word bumped to wake sleeping subscribers
+     _Atomic uint32_t waiters;                          // Number of subscribers sleeping on notify
+     _Atomic uint64_t tail;                             // Sequence number of the next slot to claim
+     _Atomic uint64_t dropped;                          // Events refused because the ring was full
+     SharedSubscriber subscribers[MAX_SHARED_SUBSCRIBERS]; // Subscriber table
+     SharedEventSlot slots[SHARED_RING_CAPACITY];       // Event ring
+ } SharedEventBus;
+ #endif
+ 
  /**
   * EventBus structure - Central hub for managing subscribers and event distribution
   */
  typedef struct EventBus {
      Subscriber subscribers[MAX_SUBSCRIBERS];  // Array of all subscribers in the system
      int subscriberCount;                      // Number of registered subscribers
+     PriorityLane lanes[PRIORITY_LANE_COUNT];  // Queued events, one lane per priority
  } EventBus;
  
  /**
@@ -79,8 +316,17 @@
      char id[MAX_ID_LENGTH];                          // Unique identifier for the agency
      char domains[MAX_EVENT_TYPES][MAX_DOMAIN_LENGTH]; // Domains this agency can publish in
      int domainCount;                                 // Number of domains the agency covers
+     unsigned long long domainMask;                   // Bit set of the domain indexes the agency covers
  } NewsAgency;
  
+ /**
+  * SharedNews structure - A published story, stored once and shared by every inbox
+  */
+ typedef struct SharedNews {
+     News news;       // The story itself, never modified after publishing
+     int refCount;    // Number of inboxes (and the publisher) still holding the story
+ } SharedNews;
+ 
  /**
   * Person structure - Represents a consumer of news
   */
@@ -88,23 +334,268 @@
      char id[MAX_ID_LENGTH];                                // Unique identifier for the person
      char interestedDomains[MAX_EVENT_TYPES][MAX_DOMAIN_LENGTH]; // News domains the person is interested in
      int domainCount;                                       // Number of domains they follow
+     unsigned long long domainMask;                         // Bit set of the domain indexes they follow
+     SharedNews *inbox[INBOX_CAPACITY];                     // Ring buffer of stories not yet delivered
+     int inboxHead;                                         // Index of the oldest story in the inbox
+     int inboxCount;                                        // Number of stories in the inbox
+     long inboxDropped;                                     // Stories dropped because the inbox was full
  } Person;
  
+ /**
+  * NamedHandler structure - Maps a handler function to a name that survives restarts
+  */
+ typedef struct NamedHandler {
+     char name[MAX_HANDLER_NAME_LENGTH];   // Name stored in snapshots and journals
+     EventHandler handler;                 // The handler function
+ } NamedHandler;
+ 
+ /**
+  * SnapshotHeader structure - Start of a snapshot file, followed by the records it counts
+  */
+ typedef struct SnapshotHeader {
+     char magic[8];            // SNAPSHOT_MAGIC
+     int version;              // SNAPSHOT_VERSION
+     int layoutSize;           // Sum of record sizes, rejects snapshots from a differently built program
+     unsigned long long generation; // Unique per saved snapshot; only a journal with the same generation is replayed
+     int subscriberCount;      // Number of SnapshotSubscriber records
+     int newsAgencyCount;      // Number of NewsAgency records
+     int peopleCount;          // Number of SnapshotPerson records
+     int domainCount;          // Number of rows in each domain table
+ } SnapshotHeader;
+ 
+ /**
+  * SnapshotSubscriber structure - Subscriber as stored in a snapshot (handler saved by name)
+  */
+ typedef struct SnapshotSubscriber {
+     char id[MAX_ID_LENGTH];                            // Unique identifier for the subscriber
+     char eventTypes[MAX_EVENT_TYPES][MAX_TYPE_LENGTH]; // Event types this subscriber listens for
+     int eventTypeCount;                                // Number of event types registered
+     char handlerName[MAX_HANDLER_NAME_LENGTH];         // Registered name of the handler
+     int conflated;                                     // Nonzero if the subscriber uses conflation
+ } SnapshotSubscriber;
+ 
+ /**
+  * SnapshotPerson structure - Person as stored in a snapshot (the inbox is not saved)
+  */
+ typedef struct SnapshotPerson {
+     char id[MAX_ID_LENGTH];                                // Unique identifier for the person
+     char interestedDomains[MAX_EVENT_TYPES][MAX_DOMAIN_LENGTH]; // News domains the person is interested in
+     int domainCount;                                       // Number of domains they follow
+     unsigned long long domainMask;                         // Bit set of the domain indexes they follow
+ } SnapshotPerson;
+ 
+ /**
+  * Kinds of registry changes recorded in the delta journal
+  */
+ typedef enum JournalOp {
+     JOURNAL_SUBSCRIBE = 1,
+     JOURNAL_UNSUBSCRIBE,
+     JOURNAL_ENABLE_CONFLATION,
+     JOURNAL_REGISTER_AGENCY,
+     JOURNAL_ADD_AGENCY_DOMAIN,
+     JOURNAL_REGISTER_PERSON,
+     JOURNAL_PERSON_SUBSCRIBE,
+     JOURNAL_PERSON_UNSUBSCRIBE
+ } JournalOp;
+ 
+ /**
+  * JournalHeader structure - Start of a journal file, naming the snapshot it applies to
+  */
+ typedef struct JournalHeader {
+     char magic[8];                  // JOURNAL_MAGIC
+     int version;                    // JOURNAL_VERSION
+     unsigned long long generation;  // Generation of the snapshot the records apply on top of
+ } JournalHeader;
+ 
+ /**
+  * JournalRecord structure - One registry change made since the last snapshot
+  */
+ typedef struct JournalRecord {
+     int op;                                     // JournalOp
+     int index;                                  // Agency or person index
+     char id[MAX_ID_LENGTH];                     // Subscriber, agency or person ID
+     char name[MAX_TYPE_LENGTH];                 // Event type or domain
+     char handlerName[MAX_HANDLER_NAME_LENGTH];  // Registered name of the handler
+ } JournalRecord;
+ 
+ /**
+  * News digest handler function pointer type definition
+  * Functions of this type receive a batch of stories from a person's inbox
+  */
+ typedef void (*NewsDigestHandler)(Person *, const News *[], int);
+ 
  /* Global state variables */
  EventBus eventBus;                        // Central event bus for the entire system
  NewsAgency newsAgencies[MAX_NEWS_AGENCIES]; // Array of all news agencies
  int newsAgencyCount = 0;                  // Number of registered news agencies
  Person people[MAX_PEOPLE];                // Array of all people
  int peopleCount = 0;                      // Number of registered people
+ char domains[MAX_DOMAINS][MAX_DOMAIN_LENGTH]; // Registry of all news domains
+ int domainCount = 0;                      // Number of registered domains
+ int domainSubscribers[MAX_DOMAINS][MAX_PEOPLE]; // Indexes of the people subscribed to each domain
+ int domainSubscriberCounts[MAX_DOMAINS];  // Number of people subscribed to each domain
+ ConflationTable conflationTables[MAX_CONFLATED_SUBSCRIBERS]; // Slot tables of conflating subscribers
+ int conflationTableCount = 0;             // Number of conflation tables in use
+ NamedHandler namedHandlers[MAX_NAMED_HANDLERS]; // Handlers that can be saved by name
+ int namedHandlerCount = 0;                // Number of named handlers
+ FILE *journalFile = NULL;                 // Open delta journal, or NULL if not journaling
+ char openJournalPath[MAX_DATA_LENGTH];    // Path of the open delta journal
+ unsigned long long snapshotGeneration = 0; // Generation of the last snapshot saved or loaded (0 = none)
+ int journalReplaying = 0;                 // Nonzero while the journal is being replayed
+ ThreadMetrics metricBlocks[MAX_METRIC_THREADS + 1]; // Per-thread counters; the last block keeps released threads' totals
+ atomic_int metricBlockUsed[MAX_METRIC_THREADS]; // Nonzero while a thread owns the block
+ atomic_int metricBlocksExhausted = 0;     // Set once a thread found no free block
+ _Thread_local ThreadMetrics *localMetrics = NULL; // Metric counters of the calling thread
+ char topicNames[MAX_TOPICS][MAX_TYPE_LENGTH]; // Event types tracked by the metrics (append only)
+ atomic_int topicCount = 0;                // Number of tracked event types, published after the name
+ atomic_flag topicLock = ATOMIC_FLAG_INIT; // Serializes topic registration
+ SlowConsumerPolicy slowConsumerPolicy = SLOW_POLICY_FLAG; // Reaction to slow subscribers
+ long long slowConsumerBudgetNs = 0;       // Handler latency budget (0 = no budget)
+ int slowConsumerMaxViolations = 1;        // Over-budget calls in a row before the policy applies
+ 
+ /* Names of the priority lanes, indexed by EventPriority */
+ const char *laneNames[PRIORITY_LANE_COUNT] = {"Critical", "Normal", "Bulk"};
  
  /**
   * Initialize the EventBus and random number generator for sensor simulation
   */
  void initEventBus() {
      eventBus.subscriberCount = 0;
+     memset(eventBus.lanes, 0, sizeof(eventBus.lanes));
+     conflationTableCount = 0;
      srand(time(NULL)); // Initialize random number generator for sensor simulation
  }
  
+ /**
+  * Register a handler under a stable name, so snapshots and journals can refer to it
+  * 
+  * @param name - Name of the handler (usually the function name)
+  * @param handler - The handler function
+  */
+ void registerHandler(char *name, EventHandler handler) {
+     if (namedHandlerCount >= MAX_NAMED_HANDLERS) {
+         printf("Max named handlers reached!\n");
+         return;
+     }
+     strcpy(namedHandlers[namedHandlerCount].name, name);
+     namedHandlers[namedHandlerCount].handler = handler;
+     namedHandlerCount++;
+ }
+ 
+ /**
+  * Get the registered name of a handler
+  * 
+  * @param handler - The handler function
+  * @return - Name of the handler, or "" if it was never registered
+  */
+ const char *handlerName(EventHandler handler) {
+     for (int i = 0; i < namedHandlerCount; i++) {
+         if (namedHandlers[i].handler == handler) {
+             return namedHandlers[i].name;
+         }
+     }
+     return "";
+ }
+ 
+ /**
+  * Find a handler by its registered name
+  * 
+  * @param name - Name of the handler
+  * @return - The handler function, or NULL if no handler has that name
+  */
+ EventHandler findHandler(const char *name) {
+     for (int i = 0; i < namedHandlerCount; i++) {
+         if (strcmp(namedHandlers[i].name, name) == 0) {
+             return namedHandlers[i].handler;
+         }
+     }
+     return NULL;
+ }
+ 
+ /**
+  * Append a registry change to the delta journal, if one is open
+  * 
+  * @param op - Kind of change
+  * @param index - Agency or person index the change applies to (if any)
+  * @param id - Subscriber, agency or person ID (if any)
+  * @param name - Event type or domain (if any)
+  * @param handler - Handler of the subscriber (if any)
+  */
+ void journalRecord(JournalOp op, int index, char *id, char *name, EventHandler handler) {
+     if (journalFile == NULL || journalReplaying) {
+         return;
+     }
+     
+     JournalRecord record;
+     memset(&record, 0, sizeof(record));
+     record.op = op;
+     record.index = index;
+     if (id != NULL) {
+         strcpy(record.id, id);
+     }
+     if (name != NULL) {
+         strcpy(record.name, name);
+     }
+     if (handler != NULL) {
+         strcpy(record.handlerName, handlerName(handler));
+     }
+     fwrite(&record, sizeof(record), 1, journalFile);
+     fflush(journalFile);
+ }
+ 
+ /**
+  * Look up the metrics index of an already registered event type
+  * 
+  * @param eventType - Event type (topic)
+  * @param count - Number of registered topics to search
+  * @return - Index of the topic, or -1 if it is not registered
+  */
+ int findTopic(const char *eventType, int count) {
+     for (int i = 0; i < count; i++) {
+         if (strcmp(topicNames[i], eventType) == 0) {
+             return i;
+         }
+     }
+     return -1;
+ }
+ 
+ /**
+  * Register an event type with the metrics
+  * Topics are only appended and the count is published after the name, so
+  * dispatching threads can look topics up without taking the lock
+  * 
+  * @param eventType - Event type (topic)
+  * @return - Index of the topic, or -1 if the topic table is full
+  */
+ int registerTopic(const char *eventType) {
+     while (atomic_flag_test_and_set_explicit(&topicLock, memory_order_acquire)) {
+         // Registration only happens for new topics, so the lock is never held for long
+     }
+     
+     int count = atomic_load_explicit(&topicCount, memory_order_relaxed);
+     int topic = findTopic(eventType, count);
+     if (topic == -1 && count < MAX_TOPICS) {
+         strcpy(topicNames[count], eventType);
+         atomic_store_explicit(&topicCount, count + 1, memory_order_release);
+         topic = count;
+     }
+     
+     atomic_flag_clear_explicit(&topicLock, memory_order_release);
+     return topic;
+ }
+ 
+ /**
+  * Get the metrics index of an event type, registering it if needed
+  * Subscribed types are registered up front, so dispatch normally only looks up
+  * 
+  * @param eventType - Event type (topic)
+  * @return - Index of the topic, or -1 if the topic table is full
+  */
+ int topicIndex(const char *eventType) {
+     int topic = findTopic(eventType, atomic_load_explicit(&topicCount, memory_order_acquire));
+     return topic != -1 ? topic : registerTopic(eventType);
+ }
+ 
  /**
   * Register a subscriber for an event type
   * If the subscriber already exists, adds the new event type to their interests
@@ -132,6 +623,8 @@
              if (eventBus.subscribers[i].eventTypeCount < MAX_EVENT_TYPES) {
                  strcpy(eventBus.subscribers[i].eventTypes[eventBus.subscribers[i].eventTypeCount], eventType);
                  eventBus.subscribers[i].eventTypeCount++;
+                 registerTopic(eventType);
+                 journalRecord(JOURNAL_SUBSCRIBE, -1, subscriberId, eventType, handler);
                  printf("Subscriber %s subscribed to additional event type: %s\n", subscriberId, eventType);
              } else {
                  printf("Max event types reached for subscriber %s\n", subscriberId);
@@ -150,7 +643,14 @@
      strcpy(eventBus.subscribers[eventBus.subscriberCount].eventTypes[0], eventType);
      eventBus.subscribers[eventBus.subscriberCount].eventTypeCount = 1;
      eventBus.subscribers[eventBus.subscriberCount].handler = handler;
+     eventBus.subscribers[eventBus.subscriberCount].conflationTable = -1;
+     eventBus.subscribers[eventBus.subscriberCount].slowViolations = 0;
+     eventBus.subscribers[eventBus.subscriberCount].throttleRemaining = 0;
+     eventBus.subscribers[eventBus.subscriberCount].flaggedSlow = 0;
+     eventBus.subscribers[eventBus.subscriberCount].detached = 0;
      eventBus.subscriberCount++;
+     registerTopic(eventType);
+     journalRecord(JOURNAL_SUBSCRIBE, -1, subscriberId, eventType, handler);
      printf("New subscriber %s registered for event type: %s\n", subscriberId, eventType);
  }
  
@@ -171,6 +671,7 @@
                          strcpy(eventBus.subscribers[i].eventTypes[k], eventBus.subscribers[i].eventTypes[k + 1]);
                      }
                      eventBus.subscribers[i].eventTypeCount--;
+                     journalRecord(JOURNAL_UNSUBSCRIBE, -1, subscriberId, eventType, NULL);
                      printf("Subscriber %s unsubscribed from event type: %s\n", subscriberId, eventType);
                      return;
                  }
@@ -183,172 +684,1005 @@
  }
  
  /**
-  * Publish an event to all interested subscribers
-  * Notifies all subscribers that are registered for the given event type
+  * Read the monotonic clock
   * 
-  * @param eventType - Type of event being published
-  * @param data - Pointer to the event data
-  * @param sourceId - ID of the publisher
+  * @return - Current monotonic time in nanoseconds
   */
- void publish(char *eventType, void *data, char *sourceId) {
-     Event event;
-     strcpy(event.type, eventType);
-     event.data = data;
-     strcpy(event.sourceId, sourceId);
-     
-     printf("Publishing event type: %s from source: %s\n", eventType, sourceId);
-     
-     // Notify all subscribers who are interested in this event type
-     for (int i = 0; i < eventBus.subscriberCount; i++) {
-         for (int j = 0; j < eventBus.subscribers[i].eventTypeCount; j++) {
-             if (strcmp(eventBus.subscribers[i].eventTypes[j], eventType) == 0) {
-                 eventBus.subscribers[i].handler(&event);
-                 break;
-             }
-         }
+ long long currentTimeNs() {
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+ }
+ 
+ /**
+  * Add to a metric counter owned by the calling thread
+  * 
+  * @param counter - Counter in the calling thread's block
+  * @param amount - Value to add
+  */
+ void addMetric(_Atomic long long *counter, long long amount) {
+     // Single writer, so a relaxed load and store is enough (no locked add)
+     atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount, memory_order_relaxed);
+ }
+ 
+ /**
+  * Read a metric counter of any thread
+  * 
+  * @param counter - Counter to read
+  * @return - Current value
+  */
+ long long readMetric(_Atomic long long *counter) {
+     return atomic_load_explicit(counter, memory_order_relaxed);
+ }
+ 
+ /**
+  * Zero every counter of a metrics block
+  * 
+  * @param metrics - Block to clear
+  */
+ void clearMetrics(ThreadMetrics *metrics) {
+     // ThreadMetrics holds nothing but _Atomic long long counters
+     _Atomic long long *counters = (_Atomic long long *)metrics;
+     for (size_t i = 0; i < sizeof(ThreadMetrics) / sizeof(counters[0]); i++) {
+         atomic_store_explicit(&counters[i], 0, memory_order_relaxed);
      }
  }
  
  /**
-  * Register a new news agency in the system
+  * Get the metrics block of the calling thread, claiming a free one on first use
+  * At most MAX_METRIC_THREADS threads hold a block at the same time; threads beyond
+  * that record nothing until another thread calls releaseThreadMetrics
   * 
-  * @param agencyId - Unique ID for the agency
-  * @return - Index of the newly registered agency or -1 if failed
+  * @return - Counters of the calling thread, or NULL if every block is taken
   */
- int registerNewsAgency(char *agencyId) {
-     if (newsAgencyCount >= MAX_NEWS_AGENCIES) {
-         printf("Max news agencies reached!\n");
-         return -1;
+ ThreadMetrics *threadMetrics() {
+     if (localMetrics != NULL) {
+         return localMetrics;
      }
      
-     strcpy(newsAgencies[newsAgencyCount].id, agencyId);
-     newsAgencies[newsAgencyCount].domainCount = 0;
-     
-     printf("News agency %s registered\n", agencyId);
-     return newsAgencyCount++;
+     for (int slot = 0; slot < MAX_METRIC_THREADS; slot++) {
+         int expected = 0;
+         if (atomic_load_explicit(&metricBlockUsed[slot], memory_order_relaxed) == 0 && 
+             atomic_compare_exchange_strong(&metricBlockUsed[slot], &expected, 1)) {
+             localMetrics = &metricBlocks[slot];
+             return localMetrics;
+         }
+     }
+     if (!atomic_exchange(&metricBlocksExhausted, 1)) {
+         printf("Warning: more than %d threads are dispatching, extra threads record no metrics\n", 
+                MAX_METRIC_THREADS);
+     }
+     return NULL;
  }
  
  /**
-  * Add a news domain to a news agency's list of covered domains
-  * 
-  * @param agencyIndex - Index of the agency in the newsAgencies array
-  * @param domain - Domain name to add
+  * Hand the calling thread's metrics block back before the thread exits
+  * Its counters are kept in the shared totals block, so nothing is lost
   */
- void addDomainToAgency(int agencyIndex, char *domain) {
-     if (agencyIndex < 0 || agencyIndex >= newsAgencyCount) {
-         printf("Invalid agency index!\n");
+ void releaseThreadMetrics() {
+     if (localMetrics == NULL) {
          return;
      }
      
-     // Check if domain already exists for this agency
-     for (int i = 0; i < newsAgencies[agencyIndex].domainCount; i++) {
-         if (strcmp(newsAgencies[agencyIndex].domains[i], domain) == 0) {
-             printf("Agency %s already publishes on domain: %s\n", 
-                    newsAgencies[agencyIndex].id, domain);
-             return;
+     ThreadMetrics *totals = &metricBlocks[MAX_METRIC_THREADS];
+     for (int i = 0; i < MAX_SUBSCRIBERS; i++) {
+         atomic_fetch_add_explicit(&totals->delivered[i], readMetric(&localMetrics->delivered[i]), memory_order_relaxed);
+         atomic_fetch_add_explicit(&totals->dropped[i], readMetric(&localMetrics->dropped[i]), memory_order_relaxed);
+         atomic_fetch_add_explicit(&totals->handlerNs[i], readMetric(&localMetrics->handlerNs[i]), memory_order_relaxed);
+         long long longest = readMetric(&localMetrics->maxHandlerNs[i]);
+         long long current = readMetric(&totals->maxHandlerNs[i]);
+         while (longest > current && 
+                !atomic_compare_exchange_weak(&totals->maxHandlerNs[i], &current, longest)) {
+         }
+         for (int b = 0; b < METRIC_BUCKETS; b++) {
+             atomic_fetch_add_explicit(&totals->histogram[i][b], readMetric(&localMetrics->histogram[i][b]), memory_order_relaxed);
          }
      }
-     
-     // Add new domain if limit not reached
-     if (newsAgencies[agencyIndex].domainCount >= MAX_EVENT_TYPES) {
-         printf("Max domains reached for agency %s\n", newsAgencies[agencyIndex].id);
-         return;
+     for (int i = 0; i < MAX_TOPICS; i++) {
+         atomic_fetch_add_explicit(&totals->topicPublished[i], readMetric(&localMetrics->topicPublished[i]), memory_order_relaxed);
+         atomic_fetch_add_explicit(&totals->topicDelivered[i], readMetric(&localMetrics->topicDelivered[i]), memory_order_relaxed);
+         atomic_fetch_add_explicit(&totals->topicDropped[i], readMetric(&localMetrics->topicDropped[i]), memory_order_relaxed);
      }
      
-     strcpy(newsAgencies[agencyIndex].domains[newsAgencies[agencyIndex].domainCount], domain);
-     newsAgencies[agencyIndex].domainCount++;
-     printf("Domain %s added to agency %s\n", domain, newsAgencies[agencyIndex].id);
+     clearMetrics(localMetrics);
+     atomic_store_explicit(&metricBlockUsed[localMetrics - metricBlocks], 0, memory_order_release);
+     localMetrics = NULL;
  }
  
  /**
-  * Register a new person in the system
+  * Clear the counters of every thread (e.g., after the subscriber table is replaced)
+  * Topic names stay registered; only their counters restart
+  */
+ void resetMetrics() {
+     for (int t = 0; t <= MAX_METRIC_THREADS; t++) {
+         clearMetrics(&metricBlocks[t]);
+     }
+ }
+ 
+ /**
+  * Count an event of a topic that was dropped before reaching any subscriber
   * 
-  * @param personId - Unique ID for the person
-  * @return - Index of the newly registered person or -1 if failed
+  * @param eventType - Event type (topic)
   */
- int registerPerson(char *personId) {
-     if (peopleCount >= MAX_PEOPLE) {
-         printf("Max people reached!\n");
-         return -1;
+ void recordTopicDrop(const char *eventType) {
+     ThreadMetrics *metrics = threadMetrics();
+     int topic = topicIndex(eventType);
+     if (metrics != NULL && topic != -1) {
+         addMetric(&metrics->topicDropped[topic], 1);
      }
-     
-     strcpy(people[peopleCount].id, personId);
-     people[peopleCount].domainCount = 0;
-     
-     printf("Person %s registered\n", personId);
-     return peopleCount++;
  }
  
  /**
-  * Event handler for news events received by people
-  * Processes news events and displays appropriate messages
+  * Choose how the bus reacts to handlers that exceed their latency budget
   * 
-  * @param event - The news event that was received
+  * @param policy - Reaction once a subscriber is considered slow
+  * @param budgetUs - Maximum handler time per event, in microseconds
+  * @param maxViolations - Consecutive over-budget calls before the policy applies
   */
- void personNewsHandler(Event *event) {
-     News *news = (News *)event->data;
-     
-     // Extract the person ID from the subscriber ID (format: "Person_personId")
-     char personId[MAX_ID_LENGTH];
-     sscanf(event->sourceId, "Person_%s", personId);
-     
-     printf("[News Reception] %s received news in domain %s from %s: %s\n", 
-            personId, news->domain, news->agency, news->content);
+ void setSlowConsumerPolicy(SlowConsumerPolicy policy, long budgetUs, int maxViolations) {
+     slowConsumerPolicy = policy;
+     slowConsumerBudgetNs = budgetUs * 1000LL;
+     slowConsumerMaxViolations = maxViolations;
  }
  
  /**
-  * Subscribe a person to a specific news domain
+  * Clear the slow-consumer state of a subscriber, reattaching it if it was detached
   * 
-  * @param personIndex - Index of the person in the people array
-  * @param domain - News domain to subscribe to
+  * @param subscriberId - ID of the subscriber
   */
- void personSubscribeToDomain(int personIndex, char *domain) {
-     if (personIndex < 0 || personIndex >= peopleCount) {
-         printf("Invalid person index!\n");
-         return;
-     }
-     
-     // Check if already subscribed to this domain
-     for (int i = 0; i < people[personIndex].domainCount; i++) {
-         if (strcmp(people[personIndex].interestedDomains[i], domain) == 0) {
-             printf("Person %s already subscribed to domain: %s\n", 
-                    people[personIndex].id, domain);
+ void resetSlowConsumer(char *subscriberId) {
+     for (int i = 0; i < eventBus.subscriberCount; i++) {
+         if (strcmp(eventBus.subscribers[i].id, subscriberId) == 0) {
+             eventBus.subscribers[i].slowViolations = 0;
+             eventBus.subscribers[i].throttleRemaining = 0;
+             eventBus.subscribers[i].flaggedSlow = 0;
+             eventBus.subscribers[i].detached = 0;
              return;
          }
      }
-     
-     // Add new domain if limit not reached
-     if (people[personIndex].domainCount >= MAX_EVENT_TYPES) {
-         printf("Max domains reached for person %s\n", people[personIndex].id);
-         return;
-     }
-     
-     strcpy(people[personIndex].interestedDomains[people[personIndex].domainCount], domain);
-     people[personIndex].domainCount++;
-     
-     // Also subscribe this person to the EventBus for this domain
-     // Subscribers are named with format "Person_personId"
-     char subscriberId[MAX_ID_LENGTH];
-     sprintf(subscriberId, "Person_%s", people[personIndex].id);
-     subscribe(subscriberId, domain, personNewsHandler);
-     
-     printf("Person %s subscribed to domain: %s\n", people[personIndex].id, domain);
  }
  
  /**
-  * Unsubscribe a person from a specific news domain
+  * Call a subscriber's handler, recording metrics and applying the slow-consumer policy
   * 
-  * @param personIndex - Index of the person in the people array
-  * @param domain - News domain to unsubscribe from
+  * @param subscriber - The receiving subscriber
+  * @param event - The event to deliver
+  * @param topic - Metrics index of the event type, from topicIndex (-1 if untracked)
   */
- void personUnsubscribeFromDomain(int personIndex, char *domain) {
-     if (personIndex < 0 || personIndex >= peopleCount) {
-         printf("Invalid person index!\n");
-         return;
-     }
+ void invokeHandler(Subscriber *subscriber, Event *event, int topic) {
+     ThreadMetrics *metrics = threadMetrics();
+     int index = subscriber - eventBus.subscribers;
+     
+     // Throttled and detached subscribers lose the event
+     if (subscriber->detached || subscriber->throttleRemaining > 0) {
+         if (subscriber->throttleRemaining > 0) {
+             subscriber->throttleRemaining--;
+         }
+         if (metrics != NULL) {
+             addMetric(&metrics->dropped[index], 1);
+             if (topic != -1) {
+                 addMetric(&metrics->topicDropped[topic], 1);
+             }
+         }
+         return;
+     }
+     
+     long long start = currentTimeNs();
+     subscriber->handler(event);
+     long long elapsed = currentTimeNs() - start;
+     
+     if (metrics != NULL) {
+         int bucket = 0;
+         while (bucket < METRIC_BUCKETS - 1 && elapsed >= (1000LL << bucket)) {
+             bucket++;
+         }
+         addMetric(&metrics->delivered[index], 1);
+         addMetric(&metrics->handlerNs[index], elapsed);
+         if (elapsed > readMetric(&metrics->maxHandlerNs[index])) {
+             atomic_store_explicit(&metrics->maxHandlerNs[index], elapsed, memory_order_relaxed);
+         }
+         addMetric(&metrics->histogram[index][bucket], 1);
+         if (topic != -1) {
+             addMetric(&metrics->topicDelivered[topic], 1);
+         }
+     }
+     
+     if (slowConsumerBudgetNs <= 0 || elapsed <= slowConsumerBudgetNs) {
+         subscriber->slowViolations = 0;
+         return;
+     }
+     if (++subscriber->slowViolations < slowConsumerMaxViolations) {
+         return;
+     }
+     
+     subscriber->slowViolations = 0;
+     if (!subscriber->flaggedSlow) {
+         subscriber->flaggedSlow = 1;
+         printf("Subscriber %s is a slow consumer (%.1f us per event)\n", subscriber->id, elapsed / 1000.0);
+     }
+     if (slowConsumerPolicy == SLOW_POLICY_THROTTLE) {
+         subscriber->throttleRemaining = THROTTLE_SKIP_EVENTS;
+     } else if (slowConsumerPolicy == SLOW_POLICY_DETACH) {
+         subscriber->detached = 1;
+         printf("Subscriber %s detached\n", subscriber->id);
+     }
+ }
+ 
+ /**
+  * Aggregate the per-thread counters into a snapshot
+  * Counters are read without locking, so a snapshot taken while other threads
+  * dispatch may lag slightly behind
+  * 
+  * @param snapshot - Filled with per-subscriber and per-topic metrics
+  */
+ void takeMetricsSnapshot(BusMetricsSnapshot *snapshot) {
+     int topics = atomic_load_explicit(&topicCount, memory_order_acquire);
+     memset(snapshot, 0, sizeof(BusMetricsSnapshot));
+     
+     snapshot->subscriberCount = eventBus.subscriberCount;
+     for (int i = 0; i < eventBus.subscriberCount; i++) {
+         SubscriberMetrics *sub = &snapshot->subscribers[i];
+         strcpy(sub->id, eventBus.subscribers[i].id);
+         for (int t = 0; t <= MAX_METRIC_THREADS; t++) {
+             ThreadMetrics *metrics = &metricBlocks[t];
+             sub->delivered += readMetric(&metrics->delivered[i]);
+             sub->dropped += readMetric(&metrics->dropped[i]);
+             sub->totalHandlerNs += readMetric(&metrics->handlerNs[i]);
+             if (readMetric(&metrics->maxHandlerNs[i]) > sub->maxHandlerNs) {
+                 sub->maxHandlerNs = readMetric(&metrics->maxHandlerNs[i]);
+             }
+             for (int b = 0; b < METRIC_BUCKETS; b++) {
+                 sub->histogram[b] += readMetric(&metrics->histogram[i][b]);
+             }
+         }
+         if (eventBus.subscribers[i].conflationTable != -1) {
+             sub->queueDepth = conflationTables[eventBus.subscribers[i].conflationTable].pendingCount;
+         }
+         sub->flagged = eventBus.subscribers[i].flaggedSlow;
+         sub->throttled = eventBus.subscribers[i].throttleRemaining > 0;
+         sub->detached = eventBus.subscribers[i].detached;
+     }
+     
+     snapshot->topicCount = topics;
+     for (int i = 0; i < topics; i++) {
+         TopicMetrics *topic = &snapshot->topics[i];
+         strcpy(topic->type, topicNames[i]);
+         for (int t = 0; t <= MAX_METRIC_THREADS; t++) {
+             topic->published += readMetric(&metricBlocks[t].topicPublished[i]);
+             topic->delivered += readMetric(&metricBlocks[t].topicDelivered[i]);
+             topic->dropped += readMetric(&metricBlocks[t].topicDropped[i]);
+         }
+         
+         // Events of this topic still waiting in the priority lanes
+         for (int l = 0; l < PRIORITY_LANE_COUNT; l++) {
+             PriorityLane *lane = &eventBus.lanes[l];
+             for (int q = 0; q < lane->count; q++) {
+                 if (strcmp(lane->events[(lane->head + q) % LANE_CAPACITY].event.type, topicNames[i]) == 0) {
+                     topic->queueDepth++;
+                 }
+             }
+         }
+     }
+ }
+ 
+ /**
+  * Write a string as a JSON string literal
+  */
+ void writeJsonString(FILE *out, const char *text) {
+     fputc('"', out);
+     for (const char *c = text; *c; c++) {
+         if (*c == '"' || *c == '\\') {
+             fprintf(out, "\\%c", *c);
+         } else if ((unsigned char)*c < 0x20) {
+             fprintf(out, "\\u%04x", *c);
+         } else {
+             fputc(*c, out);
+         }
+     }
+     fputc('"', out);
+ }
+ 
+ /**
+  * Dump a metrics snapshot as JSON
+  * Histogram bucket b counts handler calls under 2^b microseconds (the last bucket is open-ended)
+  * 
+  * @param snapshot - Snapshot filled by takeMetricsSnapshot
+  * @param out - Stream to write to
+  */
+ void writeMetricsJson(BusMetricsSnapshot *snapshot, FILE *out) {
+     fprintf(out, "{\n  \"subscribers\": [");
+     for (int i = 0; i < snapshot->subscriberCount; i++) {
+         SubscriberMetrics *sub = &snapshot->subscribers[i];
+         fprintf(out, "%s\n    {\"id\": ", i > 0 ? "," : "");
+         writeJsonString(out, sub->id);
+         fprintf(out, ", \"delivered\": %ld, \"dropped\": %ld, \"queueDepth\": %d, "
+                      "\"totalHandlerNs\": %lld, \"maxHandlerNs\": %lld, \"histogram\": [", 
+                 sub->delivered, sub->dropped, sub->queueDepth, sub->totalHandlerNs, sub->maxHandlerNs);
+         for (int b = 0; b < METRIC_BUCKETS; b++) {
+             fprintf(out, "%s%ld", b > 0 ? ", " : "", sub->histogram[b]);
+         }
+         fprintf(out, "], \"flagged\": %s, \"throttled\": %s, \"detached\": %s}", 
+                 sub->flagged ? "true" : "false", sub->throttled ? "true" : "false", 
+                 sub->detached ? "true" : "false");
+     }
+     fprintf(out, "\n  ],\n  \"topics\": [");
+     for (int i = 0; i < snapshot->topicCount; i++) {
+         TopicMetrics *topic = &snapshot->topics[i];
+         fprintf(out, "%s\n    {\"type\": ", i > 0 ? "," : "");
+         writeJsonString(out, topic->type);
+         fprintf(out, ", \"published\": %ld, \"delivered\": %ld, \"dropped\": %ld, \"queueDepth\": %d}", 
+                 topic->published, topic->delivered, topic->dropped, topic->queueDepth);
+     }
+     fprintf(out, "\n  ]\n}\n");
+ }
+ 
+ /**
+  * Switch an existing subscriber to last-value conflation
+  * 
+  * @param subscriberId - ID of the subscriber
+  */
+ void enableConflation(char *subscriberId) {
+     for (int i = 0; i < eventBus.subscriberCount; i++) {
+         if (strcmp(eventBus.subscribers[i].id, subscriberId) != 0) {
+             continue;
+         }
+         if (eventBus.subscribers[i].conflationTable != -1) {
+             return;
+         }
+         if (conflationTableCount >= MAX_CONFLATED_SUBSCRIBERS) {
+             printf("Max conflated subscribers reached, %s gets every event\n", subscriberId);
+             return;
+         }
+         
+         memset(&conflationTables[conflationTableCount], 0, sizeof(ConflationTable));
+         eventBus.subscribers[i].conflationTable = conflationTableCount++;
+         journalRecord(JOURNAL_ENABLE_CONFLATION, -1, subscriberId, NULL, NULL);
+         printf("Subscriber %s switched to conflated delivery\n", subscriberId);
+         return;
+     }
+ }
+ 
+ /**
+  * Register a subscriber for an event type with last-value conflation
+  * Pending events with the same (type, sourceId) are collapsed to the newest one
+  * and delivered by drainConflatedEvents
+  * 
+  * @param subscriberId - Unique ID for the subscriber
+  * @param eventType - Event type to subscribe to
+  * @param handler - Function to handle the event when received
+  */
+ void subscribeConflated(char *subscriberId, char *eventType, EventHandler handler) {
+     subscribe(subscriberId, eventType, handler);
+     enableConflation(subscriberId);
+ }
+ 
+ /**
+  * Hash a conflation key (FNV-1a over event type and source ID)
+  * 
+  * @param event - Event whose key is hashed
+  * @return - Hash of the (type, sourceId) key
+  */
+ unsigned int conflationHash(Event *event) {
+     unsigned int hash = 2166136261u;
+     for (const char *c = event->type; *c; c++) {
+         hash = (hash ^ (unsigned char)*c) * 16777619u;
+     }
+     hash = (hash ^ '/') * 16777619u;
+     for (const char *c = event->sourceId; *c; c++) {
+         hash = (hash ^ (unsigned char)*c) * 16777619u;
+     }
+     return hash;
+ }
+ 
+ /**
+  * Drop the reference a stored event holds on its data
+  * 
+  * @param event - Event kept by the bus
+  */
+ void releaseEventData(Event *event) {
+     if (event->release != NULL) {
+         event->release(event->data);
+     }
+     event->data = NULL;
+     event->retain = NULL;
+     event->release = NULL;
+ }
+ 
+ /**
+  * Release the pending events of every conflation table
+  */
+ void clearConflationTables() {
+     for (int i = 0; i < conflationTableCount; i++) {
+         for (int j = 0; j < CONFLATION_SLOTS; j++) {
+             if (conflationTables[i].slots[j].pending) {
+                 releaseEventData(&conflationTables[i].slots[j].latest);
+             }
+         }
+     }
+     conflationTableCount = 0;
+ }
+ 
+ /**
+  * Store an event in a subscriber's conflation table, replacing any pending event with the same key
+  * 
+  * @param subscriber - The conflating subscriber
+  * @param event - The event to store
+  * @param topic - Metrics index of the event type, from topicIndex (-1 if untracked)
+  */
+ void conflateEvent(Subscriber *subscriber, Event *event, int topic) {
+     ConflationTable *table = &conflationTables[subscriber->conflationTable];
+     unsigned int index = conflationHash(event) & (CONFLATION_SLOTS - 1);
+     
+     for (int probe = 0; probe < CONFLATION_SLOTS; probe++) {
+         ConflationSlot *slot = &table->slots[(index + probe) & (CONFLATION_SLOTS - 1)];
+         
+         if (!slot->used) {
+             slot->used = 1;
+             slot->topic = topic;
+         } else if (strcmp(slot->latest.type, event->type) != 0 || 
+                    strcmp(slot->latest.sourceId, event->sourceId) != 0) {
+             continue;
+         }
+         
+         if (slot->pending) {
+             table->conflated++;
+             releaseEventData(&slot->latest);
+         } else {
+             slot->pending = 1;
+             table->pendingCount++;
+         }
+         slot->latest = *event;
+         if (slot->latest.retain != NULL) {
+             slot->latest.retain(slot->latest.data);
+         }
+         return;
+     }
+     
+     // Every slot holds another key: fall back to immediate delivery
+     table->overflowed++;
+     invokeHandler(subscriber, event, topic);
+ }
+ 
+ /**
+  * Deliver the pending events of every conflating subscriber, one per (type, sourceId) key
+  * 
+  * @return - Number of events delivered
+  */
+ int drainConflatedEvents() {
+     int delivered = 0;
+     
+     for (int i = 0; i < eventBus.subscriberCount; i++) {
+         if (eventBus.subscribers[i].conflationTable == -1) {
+             continue;
+         }
+         
+         ConflationTable *table = &conflationTables[eventBus.subscribers[i].conflationTable];
+         for (int j = 0; j < CONFLATION_SLOTS && table->pendingCount > 0; j++) {
+             if (table->slots[j].pending) {
+                 // Take the event out of the slot first: the handler may publish a new
+                 // event with the same key, which conflateEvent stores in this slot
+                 Event latest = table->slots[j].latest;
+                 table->slots[j].latest.data = NULL;
+                 table->slots[j].latest.retain = NULL;
+                 table->slots[j].latest.release = NULL;
+                 table->slots[j].pending = 0;
+                 table->pendingCount--;
+                 invokeHandler(&eventBus.subscribers[i], &latest, table->slots[j].topic);
+                 releaseEventData(&latest);
+                 delivered++;
+             }
+         }
+     }
+     return delivered;
+ }
+ 
+ /**
+  * Print how many events each conflating subscriber was spared
+  */
+ void printConflationStatistics() {
+     for (int i = 0; i < eventBus.subscriberCount; i++) {
+         if (eventBus.subscribers[i].conflationTable == -1) {
+             continue;
+         }
+         ConflationTable *table = &conflationTables[eventBus.subscribers[i].conflationTable];
+         printf("[Conflation %s] pending: %d, conflated: %ld, overflowed: %ld\n", 
+                eventBus.subscribers[i].id, table->pendingCount, table->conflated, table->overflowed);
+     }
+ }
+ 
+ /**
+  * Deliver an event to all subscribers registered for its type
+  * Conflating subscribers only get the event stored in their slot table
+  * 
+  * @param event - The event to deliver
+  */
+ void deliverEvent(Event *event) {
+     ThreadMetrics *metrics = threadMetrics();
+     int topic = topicIndex(event->type);
+     if (metrics != NULL && topic != -1) {
+         addMetric(&metrics->topicPublished[topic], 1);
+     }
+     
+     for (int i = 0; i < eventBus.subscriberCount; i++) {
+         for (int j = 0; j < eventBus.subscribers[i].eventTypeCount; j++) {
+             if (strcmp(eventBus.subscribers[i].eventTypes[j], event->type) == 0) {
+                 if (eventBus.subscribers[i].conflationTable != -1) {
+                     conflateEvent(&eventBus.subscribers[i], event, topic);
+                 } else {
+                     invokeHandler(&eventBus.subscribers[i], event, topic);
+                 }
+                 break;
+             }
+         }
+     }
+ }
+ 
+ /**
+  * Publish reference-counted data to all interested subscribers
+  * Conflating subscribers take a reference with retain and drop it with release
+  * once the event is delivered or replaced, so the publisher may drop its own
+  * reference as soon as this returns
+  * 
+  * @param eventType - Type of event being published
+  * @param data - Pointer to the event data
+  * @param sourceId - ID of the publisher
+  * @param retain - Takes a reference to data
+  * @param release - Drops a reference to data
+  */
+ void publishShared(char *eventType, void *data, char *sourceId, EventDataCallback retain, EventDataCallback release) {
+     Event event;
+     strcpy(event.type, eventType);
+     event.data = data;
+     strcpy(event.sourceId, sourceId);
+     event.retain = retain;
+     event.release = release;
+     
+     printf("Publishing event type: %s from source: %s\n", eventType, sourceId);
+     
+     // Notify all subscribers who are interested in this event type
+     deliverEvent(&event);
+ }
+ 
+ /**
+  * Publish an event to all interested subscribers
+  * Notifies all subscribers that are registered for the given event type
+  * Conflating subscribers keep the data pointer until drainConflatedEvents, so data
+  * must stay valid until then; publishers that free data should use publishShared
+  * 
+  * @param eventType - Type of event being published
+  * @param data - Pointer to the event data
+  * @param sourceId - ID of the publisher
+  */
+ void publish(char *eventType, void *data, char *sourceId) {
+     publishShared(eventType, data, sourceId, NULL, NULL);
+ }
+ 
+ /**
+  * Queue an event in the lane of the given priority
+  * The event is delivered later by dispatchEvents, so data must stay valid until then
+  * (and until drainConflatedEvents for conflating subscribers)
+  * 
+  * @param eventType - Type of event being published
+  * @param data - Pointer to the event data
+  * @param sourceId - ID of the publisher
+  * @param priority - Lane the event is queued in
+  * @param deadlineUs - Microseconds after which the event is dropped if still queued (0 = no deadline)
+  * @return - 0 on success, -1 if the priority is invalid or the lane is full
+  */
+ int publishWithPriority(char *eventType, void *data, char *sourceId, EventPriority priority, long deadlineUs) {
+     if ((int)priority < 0 || priority >= PRIORITY_LANE_COUNT) {
+         printf("Invalid priority!\n");
+         return -1;
+     }
+     
+     PriorityLane *lane = &eventBus.lanes[priority];
+     
+     if (lane->count >= LANE_CAPACITY) {
+         lane->rejected++;
+         recordTopicDrop(eventType);
+         printf("%s lane full, dropping event type: %s from source: %s\n", 
+                laneNames[priority], eventType, sourceId);
+         return -1;
+     }
+     
+     QueuedEvent *queued = &lane->events[(lane->head + lane->count) % LANE_CAPACITY];
+     strcpy(queued->event.type, eventType);
+     queued->event.data = data;
+     queued->event.retain = NULL;
+     queued->event.release = NULL;
+     strcpy(queued->event.sourceId, sourceId);
+     queued->enqueuedNs = currentTimeNs();
+     queued->deadlineNs = deadlineUs > 0 ? queued->enqueuedNs + deadlineUs * 1000LL : 0;
+     
+     lane->count++;
+     if (lane->count > lane->maxDepth) {
+         lane->maxDepth = lane->count;
+     }
+     return 0;
+ }
+ 
+ /**
+  * Choose the lane to serve next
+  * Higher lanes always win, unless a lower lane has been passed over STARVATION_LIMIT times
+  * 
+  * @return - Index of the lane to serve, or -1 if all lanes are empty
+  */
+ int selectLane() {
+     int highest = -1;
+     
+     for (int i = 0; i < PRIORITY_LANE_COUNT; i++) {
+         if (eventBus.lanes[i].count == 0) {
+             continue;
+         }
+         if (highest == -1) {
+             highest = i;
+         } else if (eventBus.lanes[i].passedOver >= STARVATION_LIMIT) {
+             return i;
+         }
+     }
+     return highest;
+ }
+ 
+ /**
+  * Dispatch queued events, always draining higher priority lanes first
+  * Events whose deadline has passed are dropped instead of delivered
+  * 
+  * @param maxEvents - Maximum number of events to dispatch (0 = until all lanes are empty)
+  * @return - Number of events delivered
+  */
+ int dispatchEvents(int maxEvents) {
+     int delivered = 0;
+     int lane;
+     
+     while ((maxEvents == 0 || delivered < maxEvents) && (lane = selectLane()) != -1) {
+         PriorityLane *current = &eventBus.lanes[lane];
+         // Copy the event out: once the slot is released a handler may publish into it
+         QueuedEvent copy = current->events[current->head];
+         QueuedEvent *queued = &copy;
+         current->head = (current->head + 1) % LANE_CAPACITY;
+         current->count--;
+         current->passedOver = 0;
+         
+         // Every other waiting lane was passed over by this dispatch
+         for (int i = 0; i < PRIORITY_LANE_COUNT; i++) {
+             if (i != lane && eventBus.lanes[i].count > 0) {
+                 eventBus.lanes[i].passedOver++;
+             }
+         }
+         
+         long long now = currentTimeNs();
+         if (queued->deadlineNs != 0 && now > queued->deadlineNs) {
+             current->expired++;
+             recordTopicDrop(queued->event.type);
+             printf("Dropping stale event type: %s from source: %s\n", 
+                    queued->event.type, queued->event.sourceId);
+             continue;
+         }
+         
+         long long latency = now - queued->enqueuedNs;
+         current->totalLatencyNs += latency;
+         if (latency > current->maxLatencyNs) {
+             current->maxLatencyNs = latency;
+         }
+         current->dispatched++;
+         
+         printf("Dispatching %s event type: %s from source: %s\n", 
+                laneNames[lane], queued->event.type, queued->event.sourceId);
+         deliverEvent(&queued->event);
+         delivered++;
+     }
+     return delivered;
+ }
+ 
+ /**
+  * Print queue depth and dispatch latency of every priority lane
+  */
+ void printLaneStatistics() {
+     for (int i = 0; i < PRIORITY_LANE_COUNT; i++) {
+         PriorityLane *lane = &eventBus.lanes[i];
+         double avgLatencyUs = lane->dispatched > 0 ? 
+                               lane->totalLatencyNs / 1000.0 / lane->dispatched : 0.0;
+         printf("[Lane %s] depth: %d, max depth: %d, dispatched: %ld, expired: %ld, rejected: %ld, "
+                "avg latency: %.1f us, max latency: %.1f us\n", 
+                laneNames[i], lane->count, lane->maxDepth, lane->dispatched, lane->expired, 
+                lane->rejected, avgLatencyUs, lane->maxLatencyNs / 1000.0);
+     }
+ }
+ 
+ /**
+  * Find the index of a news domain in the domain registry
+  * 
+  * @param domain - Domain name to look up
+  * @return - Index of the domain, or -1 if it is not registered
+  */
+ int findDomain(char *domain) {
+     for (int i = 0; i < domainCount; i++) {
+         if (strcmp(domains[i], domain) == 0) {
+             return i;
+         }
+     }
+     return -1;
+ }
+ 
+ /**
+  * Get the index of a news domain, registering it if needed
+  * 
+  * @param domain - Domain name to look up
+  * @return - Index of the domain, or -1 if the registry is full
+  */
+ int internDomain(char *domain) {
+     int index = findDomain(domain);
+     if (index != -1) {
+         return index;
+     }
+     if (domainCount >= MAX_DOMAINS) {
+         printf("Max domains reached!\n");
+         return -1;
+     }
+     strcpy(domains[domainCount], domain);
+     domainSubscriberCounts[domainCount] = 0;
+     return domainCount++;
+ }
+ 
+ /**
+  * Register a new news agency in the system
+  * 
+  * @param agencyId - Unique ID for the agency
+  * @return - Index of the newly registered agency or -1 if failed
+  */
+ int registerNewsAgency(char *agencyId) {
+     if (newsAgencyCount >= MAX_NEWS_AGENCIES) {
+         printf("Max news agencies reached!\n");
+         return -1;
+     }
+     
+     strcpy(newsAgencies[newsAgencyCount].id, agencyId);
+     newsAgencies[newsAgencyCount].domainCount = 0;
+     newsAgencies[newsAgencyCount].domainMask = 0;
+     journalRecord(JOURNAL_REGISTER_AGENCY, -1, agencyId, NULL, NULL);
+     
+     printf("News agency %s registered\n", agencyId);
+     return newsAgencyCount++;
+ }
+ 
+ /**
+  * Add a news domain to a news agency's list of covered domains
+  * 
+  * @param agencyIndex - Index of the agency in the newsAgencies array
+  * @param domain - Domain name to add
+  */
+ void addDomainToAgency(int agencyIndex, char *domain) {
+     if (agencyIndex < 0 || agencyIndex >= newsAgencyCount) {
+         printf("Invalid agency index!\n");
+         return;
+     }
+     
+     int domainIndex = internDomain(domain);
+     if (domainIndex == -1) {
+         return;
+     }
+     
+     // Check if domain already exists for this agency
+     if (newsAgencies[agencyIndex].domainMask & (1ULL << domainIndex)) {
+         printf("Agency %s already publishes on domain: %s\n", 
+                newsAgencies[agencyIndex].id, domain);
+         return;
+     }
+     
+     // Add new domain if limit not reached
+     if (newsAgencies[agencyIndex].domainCount >= MAX_EVENT_TYPES) {
+         printf("Max domains reached for agency %s\n", newsAgencies[agencyIndex].id);
+         return;
+     }
+     
+     strcpy(newsAgencies[agencyIndex].domains[newsAgencies[agencyIndex].domainCount], domain);
+     newsAgencies[agencyIndex].domainCount++;
+     newsAgencies[agencyIndex].domainMask |= 1ULL << domainIndex;
+     journalRecord(JOURNAL_ADD_AGENCY_DOMAIN, agencyIndex, NULL, domain, NULL);
+     printf("Domain %s added to agency %s\n", domain, newsAgencies[agencyIndex].id);
+ }
+ 
+ /**
+  * Register a new person in the system
+  * 
+  * @param personId - Unique ID for the person
+  * @return - Index of the newly registered person or -1 if failed
+  */
+ int registerPerson(char *personId) {
+     if (peopleCount >= MAX_PEOPLE) {
+         printf("Max people reached!\n");
+         return -1;
+     }
+     
+     strcpy(people[peopleCount].id, personId);
+     people[peopleCount].domainCount = 0;
+     people[peopleCount].domainMask = 0;
+     people[peopleCount].inboxHead = 0;
+     people[peopleCount].inboxCount = 0;
+     people[peopleCount].inboxDropped = 0;
+     journalRecord(JOURNAL_REGISTER_PERSON, -1, personId, NULL, NULL);
+     
+     printf("Person %s registered\n", personId);
+     return peopleCount++;
+ }
+ 
+ /**
+  * Drop a reference to a shared news story, freeing it when nobody holds it anymore
+  * 
+  * @param story - The shared story
+  */
+ void releaseNews(SharedNews *story) {
+     if (--story->refCount == 0) {
+         free(story);
+     }
+ }
+ 
+ /**
+  * Event data callbacks for shared news published on the EventBus
+  * The News is the first member of SharedNews, so the event data points at both
+  */
+ void retainNewsData(void *data) {
+     ((SharedNews *)data)->refCount++;
+ }
+ 
+ void releaseNewsData(void *data) {
+     releaseNews((SharedNews *)data);
+ }
+ 
+ /**
+  * Append a news story reference to a person's inbox
+  * When the inbox is full the oldest story is dropped, keeping memory bounded
+  * 
+  * @param person - The receiving person
+  * @param story - The shared story (the inbox takes over one reference)
+  */
+ void inboxPush(Person *person, SharedNews *story) {
+     if (person->inboxCount == INBOX_CAPACITY) {
+         releaseNews(person->inbox[person->inboxHead]);
+         person->inboxHead = (person->inboxHead + 1) % INBOX_CAPACITY;
+         person->inboxCount--;
+         person->inboxDropped++;
+     }
+     person->inbox[(person->inboxHead + person->inboxCount) % INBOX_CAPACITY] = story;
+     person->inboxCount++;
+ }
+ 
+ /**
+  * Deliver up to INBOX_BATCH_SIZE stories from a person's inbox in one handler call
+  * 
+  * @param personIndex - Index of the person in the people array
+  * @param handler - Function that receives the batch
+  * @return - Number of stories delivered (0 if the person index is invalid)
+  */
+ int drainPersonInbox(int personIndex, NewsDigestHandler handler) {
+     if (personIndex < 0 || personIndex >= peopleCount) {
+         printf("Invalid person index!\n");
+         return 0;
+     }
+     
+     Person *person = &people[personIndex];
+     SharedNews *taken[INBOX_BATCH_SIZE];
+     const News *batch[INBOX_BATCH_SIZE];
+     int count = 0;
+     
+     while (count < INBOX_BATCH_SIZE && person->inboxCount > 0) {
+         taken[count] = person->inbox[person->inboxHead];
+         batch[count] = &taken[count]->news;
+         person->inboxHead = (person->inboxHead + 1) % INBOX_CAPACITY;
+         person->inboxCount--;
+         count++;
+     }
+     
+     if (count > 0) {
+         handler(person, batch, count);
+     }
+     for (int i = 0; i < count; i++) {
+         releaseNews(taken[i]);
+     }
+     return count;
+ }
+ 
+ /**
+  * Empty every person's inbox, delivering the stories as digests
+  * Call it periodically to get digest delivery
+  * 
+  * @param handler - Function that receives each batch
+  * @return - Number of stories delivered
+  */
+ int deliverNewsDigests(NewsDigestHandler handler) {
+     int delivered = 0;
+     int count;
+     
+     for (int i = 0; i < peopleCount; i++) {
+         while ((count = drainPersonInbox(i, handler)) > 0) {
+             delivered += count;
+         }
+     }
+     return delivered;
+ }
+ 
+ /**
+  * Digest handler for news received by people
+  * Displays a batch of stories from the person's inbox
+  * 
+  * @param person - The person receiving the stories
+  * @param batch - The stories, oldest first
+  * @param count - Number of stories in the batch
+  */
+ void personDigestHandler(Person *person, const News *batch[], int count) {
+     printf("[News Digest] %s has %d new stories", person->id, count);
+     if (person->inboxDropped > 0) {
+         printf(" (%ld older stories dropped)", person->inboxDropped);
+     }
+     printf("\n");
+     
+     for (int i = 0; i < count; i++) {
+         printf("[News Reception] %s received news in domain %s from %s: %s\n", 
+                person->id, batch[i]->domain, batch[i]->agency, batch[i]->content);
+     }
+ }
+ 
+ /**
+  * Subscribe a person to a specific news domain
+  * 
+  * @param personIndex - Index of the person in the people array
+  * @param domain - News domain to subscribe to
+  */
+ void personSubscribeToDomain(int personIndex, char *domain) {
+     if (personIndex < 0 || personIndex >= peopleCount) {
+         printf("Invalid person index!\n");
+         return;
+     }
+     
+     int domainIndex = internDomain(domain);
+     if (domainIndex == -1) {
+         return;
+     }
+     
+     // Check if already subscribed to this domain
+     if (people[personIndex].domainMask & (1ULL << domainIndex)) {
+         printf("Person %s already subscribed to domain: %s\n", 
+                people[personIndex].id, domain);
+         return;
+     }
+     
+     // Add new domain if limit not reached
+     if (people[personIndex].domainCount >= MAX_EVENT_TYPES) {
+         printf("Max domains reached for person %s\n", people[personIndex].id);
+         return;
+     }
+     
+     strcpy(people[personIndex].interestedDomains[people[personIndex].domainCount], domain);
+     people[personIndex].domainCount++;
+     people[personIndex].domainMask |= 1ULL << domainIndex;
+     
+     // Also add this person to the fan-out list of the domain
+     domainSubscribers[domainIndex][domainSubscriberCounts[domainIndex]++] = personIndex;
+     journalRecord(JOURNAL_PERSON_SUBSCRIBE, personIndex, NULL, domain, NULL);
+     
+     printf("Person %s subscribed to domain: %s\n", people[personIndex].id, domain);
+ }
+ 
+ /**
+  * Unsubscribe a person from a specific news domain
+  * 
+  * @param personIndex - Index of the person in the people array
+  * @param domain - News domain to unsubscribe from
+  */
+ void personUnsubscribeFromDomain(int personIndex, char *domain) {
+     if (personIndex < 0 || personIndex >= peopleCount) {
+         printf("Invalid person index!\n");
+         return;
+     }
+     
+     int domainIndex = findDomain(domain);
+     if (domainIndex == -1 || !(people[personIndex].domainMask & (1ULL << domainIndex))) {
+         printf("Person %s not subscribed to domain: %s\n", people[personIndex].id, domain);
+         return;
+     }
      
      // Find the domain in person's interested domains
-     int domainFound = -1;
+     int domainFound = 0;
      for (int i = 0; i < people[personIndex].domainCount; i++) {
          if (strcmp(people[personIndex].interestedDomains[i], domain) == 0) {
              domainFound = i;
@@ -356,161 +1690,1211 @@
          }
      }
      
-     if (domainFound == -1) {
-         printf("Person %s not subscribed to domain: %s\n", people[personIndex].id, domain);
-         return;
+     // Remove this domain by shifting the remaining ones
+     for (int i = domainFound; i < people[personIndex].domainCount - 1; i++) {
+         strcpy(people[personIndex].interestedDomains[i], people[personIndex].interestedDomains[i + 1]);
+     }
+     people[personIndex].domainCount--;
+     people[personIndex].domainMask &= ~(1ULL << domainIndex);
+     
+     // Also remove this person from the fan-out list of the domain (order does not matter)
+     for (int i = 0; i < domainSubscriberCounts[domainIndex]; i++) {
+         if (domainSubscribers[domainIndex][i] == personIndex) {
+             domainSubscriberCounts[domainIndex]--;
+             domainSubscribers[domainIndex][i] = domainSubscribers[domainIndex][domainSubscriberCounts[domainIndex]];
+             break;
+         }
+     }
+     journalRecord(JOURNAL_PERSON_UNSUBSCRIBE, personIndex, NULL, domain, NULL);
+     
+     printf("Person %s unsubscribed from domain: %s\n", people[personIndex].id, domain);
+ }
+ 
+ /**
+  * Publish news from a news agency to interested subscribers
+  * The story is stored once and only a reference is appended to each subscriber's inbox
+  * 
+  * @param agencyIndex - Index of the publishing agency
+  * @param domain - Domain/category of the news
+  * @param content - The actual news content
+  */
+ void publishNews(int agencyIndex, char *domain, char *content) {
+     if (agencyIndex < 0 || agencyIndex >= newsAgencyCount) {
+         printf("Invalid agency index!\n");
+         return;
+     }
+     
+     // Check if agency is authorized to publish in this domain
+     int domainIndex = findDomain(domain);
+     if (domainIndex == -1 || !(newsAgencies[agencyIndex].domainMask & (1ULL << domainIndex))) {
+         printf("Agency %s does not publish in domain: %s\n", 
+                newsAgencies[agencyIndex].id, domain);
+         return;
+     }
+     
+     // Create the shared news object, referenced by the publisher and every inbox
+     int subscriberCount = domainSubscriberCounts[domainIndex];
+     SharedNews *story = malloc(sizeof(SharedNews));
+     strcpy(story->news.domain, domain);
+     strcpy(story->news.content, content);
+     strcpy(story->news.agency, newsAgencies[agencyIndex].id);
+     story->news.timestamp = time(NULL);
+     story->refCount = 1 + subscriberCount;
+     
+     for (int i = 0; i < subscriberCount; i++) {
+         inboxPush(&people[domainSubscribers[domainIndex][i]], story);
+     }
+     
+     // Publish event with domain as the event type, for other EventBus subscribers
+     publishShared(domain, &story->news, newsAgencies[agencyIndex].id, retainNewsData, releaseNewsData);
+     releaseNews(story);
+ }
+ 
+ /**
+  * Generate realistic random sensor data based on sensor type
+  * 
+  * @param sensorType - Type of the sensor (e.g., "Temperature", "WaterLevel")
+  * @return - Random value appropriate for the sensor type
+  */
+ float generateSensorData(char *sensorType) {
+     float value;
+     
+     if (strcmp(sensorType, "Temperature") == 0) {
+         value = 15.0 + ((float)rand() / RAND_MAX) * 25.0; // 15-40°C
+     } else if (strcmp(sensorType, "WaterLevel") == 0) {
+         value = ((float)rand() / RAND_MAX) * 10.0; // 0-10m
+     } else if (strcmp(sensorType, "Humidity") == 0) {
+         value = 30.0 + ((float)rand() / RAND_MAX) * 70.0; // 30-100%
+     } else {
+         value = ((float)rand() / RAND_MAX) * 100.0; // Generic 0-100
+     }
+     
+     return value;
+ }
+ 
+ /**
+  * Get the dispatch priority of a sensor type
+  * Water level readings are flood alarms and must not wait behind routine readings
+  * 
+  * @param sensorType - Type of the sensor
+  * @return - Priority lane for readings of this sensor type
+  */
+ EventPriority sensorPriority(char *sensorType) {
+     if (strcmp(sensorType, "WaterLevel") == 0) {
+         return PRIORITY_CRITICAL;
+     }
+     return PRIORITY_NORMAL;
+ }
+ 
+ /**
+  * Simulate a sensor reading and queue it on the event bus
+  * Routine readings get a deadline, critical ones are never dropped
+  * 
+  * @param sensorType - Type of the sensor
+  * @param sensorId - Unique ID for the sensor
+  */
+ void simulateSensorReading(char *sensorType, char *sensorId) {
+     float *data = malloc(sizeof(float));
+     *data = generateSensorData(sensorType);
+     
+     EventPriority priority = sensorPriority(sensorType);
+     long deadlineUs = priority == PRIORITY_CRITICAL ? 0 : SENSOR_DEADLINE_US;
+     publishWithPriority(sensorType, data, sensorId, priority, deadlineUs);
+ }
+ 
+ /**
+  * Event handler for displaying numeric sensor values
+  * Simply displays the raw value from the sensor
+  * 
+  * @param event - The sensor event that was received
+  */
+ void numericDisplayHandler(Event *event) {
+     float *value = (float *)event->data;
+     printf("[NumericDisplay] Value from %s: %.2f\n", event->sourceId, *value);
+ }
+ 
+ /**
+  * Event handler for tracking and displaying maximum sensor values
+  * Keeps track of maximum values seen for each sensor type
+  * 
+  * @param event - The sensor event that was received
+  */
+ void maxValueDisplayHandler(Event *event) {
+     // Static variables retain their values between function calls
+     static float maxTemp = -999.9, maxHumidity = -999.9, maxWater = -999.9;
+     float *value = (float *)event->data;
+ 
+     printf("[MaxValueDisplay] Received %s: %.2f from %s\n", event->type, *value, event->sourceId);
+ 
+     // Update maximum values if new value is higher
+     if (strcmp(event->type, "Temperature") == 0 && *value > maxTemp) {
+         maxTemp = *value;
+         printf("[MaxValueDisplay] New max temperature: %.2f from %s\n", maxTemp, event->sourceId);
+     } else if (strcmp(event->type, "Humidity") == 0 && *value > maxHumidity) {
+         maxHumidity = *value;
+         printf("[MaxValueDisplay] New max humidity: %.2f from %s\n", maxHumidity, event->sourceId);
+     } else if (strcmp(event->type, "WaterLevel") == 0 && *value > maxWater) {
+         maxWater = *value;
+         printf("[MaxValueDisplay] New max water level: %.2f from %s\n", maxWater, event->sourceId);
+     }
+ }
+ 
+ /**
+  * Event handler for displaying formatted text about sensor readings
+  * Presents sensor data in a more descriptive format
+  * 
+  * @param event - The sensor event that was received
+  */
+ void textDisplayHandler(Event *event) {
+     float *value = (float *)event->data;
+     printf("[TextDisplay] %s reported a %s value of %.2f\n", event->sourceId, event->type, *value);
+ }
+ 
+ /**
+  * Read a whole file into memory (memory-mapped where available)
+  * 
+  * @param path - File to read
+  * @param size - Set to the size of the file
+  * @return - Pointer to the contents, or NULL if failed
+  */
+ void *mapFile(const char *path, long *size) {
+ #ifdef __linux__
+     int fd = open(path, O_RDONLY);
+     if (fd == -1) {
+         return NULL;
+     }
+     struct stat st;
+     if (fstat(fd, &st) == -1 || st.st_size == 0) {
+         close(fd);
+         return NULL;
+     }
+     void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+     close(fd);
+     if (data == MAP_FAILED) {
+         return NULL;
+     }
+     *size = st.st_size;
+     return data;
+ #else
+     FILE *file = fopen(path, "rb");
+     if (file == NULL) {
+         return NULL;
+     }
+     fseek(file, 0, SEEK_END);
+     *size = ftell(file);
+     fseek(file, 0, SEEK_SET);
+     void *data = malloc(*size);
+     if (data == NULL || fread(data, 1, *size, file) != (size_t)*size) {
+         free(data);
+         fclose(file);
+         return NULL;
+     }
+     fclose(file);
+     return data;
+ #endif
+ }
+ 
+ /**
+  * Release memory returned by mapFile
+  */
+ void unmapFile(void *data, long size) {
+ #ifdef __linux__
+     munmap(data, size);
+ #else
+     (void)size;
+     free(data);
+ #endif
+ }
+ 
+ /**
+  * Pick the generation of a new snapshot
+  * Based on the wall clock so it also differs from snapshots saved by earlier runs
+  * 
+  * @return - Generation greater than the current one
+  */
+ unsigned long long nextSnapshotGeneration() {
+     struct timespec ts;
+     clock_gettime(CLOCK_REALTIME, &ts);
+     unsigned long long generation = (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+     return generation > snapshotGeneration ? generation : snapshotGeneration + 1;
+ }
+ 
+ /**
+  * Start an empty journal for the current snapshot generation
+  * 
+  * @param path - Journal file (truncated)
+  * @return - 0 on success, -1 if failed
+  */
+ int startJournal(const char *path) {
+     journalFile = fopen(path, "wb");
+     if (journalFile == NULL) {
+         perror("Error opening journal");
+         return -1;
+     }
+     
+     JournalHeader header;
+     memset(&header, 0, sizeof(header));
+     memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+     header.version = JOURNAL_VERSION;
+     header.generation = snapshotGeneration;
+     if (fwrite(&header, sizeof(header), 1, journalFile) != 1 || fflush(journalFile) != 0) {
+         perror("Error writing journal");
+         fclose(journalFile);
+         journalFile = NULL;
+         return -1;
+     }
+     return 0;
+ }
+ 
+ /**
+  * Save the subscriber, agency, person and domain registries to a binary snapshot
+  * The snapshot is written to a temporary file and renamed, and the journal is emptied
+  * 
+  * @param path - Snapshot file
+  * @return - 0 on success, -1 if failed
+  */
+ int saveSnapshot(const char *path) {
+     char tempPath[MAX_DATA_LENGTH];
+     snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+     
+     FILE *file = fopen(tempPath, "wb");
+     if (file == NULL) {
+         perror("Error opening snapshot");
+         return -1;
+     }
+     
+     SnapshotHeader header;
+     memset(&header, 0, sizeof(header));
+     memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+     header.version = SNAPSHOT_VERSION;
+     header.layoutSize = sizeof(SnapshotHeader) + sizeof(SnapshotSubscriber) + sizeof(NewsAgency) + sizeof(SnapshotPerson);
+     header.generation = nextSnapshotGeneration();
+     header.subscriberCount = eventBus.subscriberCount;
+     header.newsAgencyCount = newsAgencyCount;
+     header.peopleCount = peopleCount;
+     header.domainCount = domainCount;
+     int written = fwrite(&header, sizeof(header), 1, file) == 1;
+     
+     for (int i = 0; i < eventBus.subscriberCount; i++) {
+         SnapshotSubscriber record;
+         memset(&record, 0, sizeof(record));
+         strcpy(record.id, eventBus.subscribers[i].id);
+         memcpy(record.eventTypes, eventBus.subscribers[i].eventTypes, sizeof(record.eventTypes));
+         record.eventTypeCount = eventBus.subscribers[i].eventTypeCount;
+         strcpy(record.handlerName, handlerName(eventBus.subscribers[i].handler));
+         record.conflated = eventBus.subscribers[i].conflationTable != -1;
+         written = written && fwrite(&record, sizeof(record), 1, file) == 1;
+     }
+     
+     written = written && fwrite(newsAgencies, sizeof(NewsAgency), newsAgencyCount, file) == (size_t)newsAgencyCount;
+     
+     for (int i = 0; i < peopleCount; i++) {
+         SnapshotPerson record;
+         memset(&record, 0, sizeof(record));
+         strcpy(record.id, people[i].id);
+         memcpy(record.interestedDomains, people[i].interestedDomains, sizeof(record.interestedDomains));
+         record.domainCount = people[i].domainCount;
+         record.domainMask = people[i].domainMask;
+         written = written && fwrite(&record, sizeof(record), 1, file) == 1;
+     }
+     
+     written = written && fwrite(domains, sizeof(domains[0]), domainCount, file) == (size_t)domainCount;
+     written = written && fwrite(domainSubscriberCounts, sizeof(int), domainCount, file) == (size_t)domainCount;
+     written = written && fwrite(domainSubscribers, sizeof(domainSubscribers[0]), domainCount, file) == (size_t)domainCount;
+     
+     // fclose runs even after a failed write so the file is never leaked
+     if (fclose(file) != 0 || !written || rename(tempPath, path) != 0) {
+         perror("Error writing snapshot");
+         remove(tempPath);
+         return -1;
+     }
+     
+     // The snapshot now contains every journaled change; if we crash before the journal
+     // is restarted, its old generation keeps it from being replayed on the new snapshot
+     snapshotGeneration = header.generation;
+     if (journalFile != NULL) {
+         fclose(journalFile);
+         startJournal(openJournalPath);
+     }
+     
+     printf("Snapshot saved to %s: %d subscribers, %d agencies, %d people, %d domains\n", 
+            path, eventBus.subscriberCount, newsAgencyCount, peopleCount, domainCount);
+     return 0;
+ }
+ 
+ /**
+  * Check that a fixed size string field read from a file is NUL terminated
+  * 
+  * @param text - String field
+  * @param size - Size of the field
+  * @return - 1 if terminated, 0 otherwise
+  */
+ int isTerminated(const char *text, size_t size) {
+     return memchr(text, '\0', size) != NULL;
+ }
+ 
+ /**
+  * Check that a domain bit set only names registered domains
+  * 
+  * @param mask - Bit set of domain indexes
+  * @param count - Number of registered domains
+  * @return - 1 if valid, 0 otherwise
+  */
+ int isValidDomainMask(unsigned long long mask, int count) {
+     return count >= MAX_DOMAINS || (mask >> count) == 0;
+ }
+ 
+ /**
+  * Bound-check every record of a snapshot image before any of it is used
+  * 
+  * @param header - Snapshot header, already checked against this build
+  * @param records - First record after the header
+  * @return - 0 if every record is valid, -1 otherwise
+  */
+ int validateSnapshot(const SnapshotHeader *header, const char *records) {
+     const char *cursor = records;
+     
+     for (int i = 0; i < header->subscriberCount; i++) {
+         const SnapshotSubscriber *record = (const SnapshotSubscriber *)cursor;
+         if (!isTerminated(record->id, sizeof(record->id)) || 
+             !isTerminated(record->handlerName, sizeof(record->handlerName)) || 
+             record->eventTypeCount < 0 || record->eventTypeCount > MAX_EVENT_TYPES) {
+             return -1;
+         }
+         for (int j = 0; j < record->eventTypeCount; j++) {
+             if (!isTerminated(record->eventTypes[j], sizeof(record->eventTypes[j]))) {
+                 return -1;
+             }
+         }
+         cursor += sizeof(SnapshotSubscriber);
+     }
+     
+     for (int i = 0; i < header->newsAgencyCount; i++) {
+         const NewsAgency *agency = (const NewsAgency *)cursor;
+         if (!isTerminated(agency->id, sizeof(agency->id)) || 
+             agency->domainCount < 0 || agency->domainCount > MAX_EVENT_TYPES || 
+             !isValidDomainMask(agency->domainMask, header->domainCount)) {
+             return -1;
+         }
+         for (int j = 0; j < agency->domainCount; j++) {
+             if (!isTerminated(agency->domains[j], sizeof(agency->domains[j]))) {
+                 return -1;
+             }
+         }
+         cursor += sizeof(NewsAgency);
+     }
+     
+     for (int i = 0; i < header->peopleCount; i++) {
+         const SnapshotPerson *record = (const SnapshotPerson *)cursor;
+         if (!isTerminated(record->id, sizeof(record->id)) || 
+             record->domainCount < 0 || record->domainCount > MAX_EVENT_TYPES || 
+             !isValidDomainMask(record->domainMask, header->domainCount)) {
+             return -1;
+         }
+         for (int j = 0; j < record->domainCount; j++) {
+             if (!isTerminated(record->interestedDomains[j], sizeof(record->interestedDomains[j]))) {
+                 return -1;
+             }
+         }
+         cursor += sizeof(SnapshotPerson);
+     }
+     
+     for (int i = 0; i < header->domainCount; i++) {
+         if (!isTerminated(cursor, sizeof(domains[0]))) {
+             return -1;
+         }
+         cursor += sizeof(domains[0]);
+     }
+     
+     const int *subscriberCounts = (const int *)cursor;
+     for (int i = 0; i < header->domainCount; i++) {
+         if (subscriberCounts[i] < 0 || subscriberCounts[i] > header->peopleCount) {
+             return -1;
+         }
+     }
+     cursor += header->domainCount * sizeof(int);
+     
+     const int (*subscribers)[MAX_PEOPLE] = (const int (*)[MAX_PEOPLE])cursor;
+     for (int i = 0; i < header->domainCount; i++) {
+         for (int j = 0; j < subscriberCounts[i]; j++) {
+             if (subscribers[i][j] < 0 || subscribers[i][j] >= header->peopleCount) {
+                 return -1;
+             }
+         }
+     }
+     
+     return 0;
+ }
+ 
+ /**
+  * Replace the registries with the contents of a binary snapshot
+  * 
+  * @param path - Snapshot file
+  * @return - 0 on success, -1 if the snapshot is missing, corrupt or does not match this build
+  */
+ int loadSnapshot(const char *path) {
+     long size;
+     char *data = mapFile(path, &size);
+     if (data == NULL) {
+         return -1;
+     }
+     
+     SnapshotHeader *header = (SnapshotHeader *)data;
+     int layoutSize = sizeof(SnapshotHeader) + sizeof(SnapshotSubscriber) + sizeof(NewsAgency) + sizeof(SnapshotPerson);
+     if (size < (long)sizeof(SnapshotHeader) || 
+         memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || 
+         header->version != SNAPSHOT_VERSION || header->layoutSize != layoutSize) {
+         printf("Snapshot %s is not compatible with this build\n", path);
+         unmapFile(data, size);
+         return -1;
+     }
+     
+     // Every count sizes a copy below, so both ends are checked; saved snapshots never have generation 0
+     if (header->subscriberCount < 0 || header->subscriberCount > MAX_SUBSCRIBERS || 
+         header->newsAgencyCount < 0 || header->newsAgencyCount > MAX_NEWS_AGENCIES || 
+         header->peopleCount < 0 || header->peopleCount > MAX_PEOPLE || 
+         header->domainCount < 0 || header->domainCount > MAX_DOMAINS || header->generation == 0) {
+         printf("Snapshot %s is corrupt\n", path);
+         unmapFile(data, size);
+         return -1;
+     }
+     
+     long expected = sizeof(SnapshotHeader) + 
+                     header->subscriberCount * (long)sizeof(SnapshotSubscriber) + 
+                     header->newsAgencyCount * (long)sizeof(NewsAgency) + 
+                     header->peopleCount * (long)sizeof(SnapshotPerson) + 
+                     header->domainCount * (long)(sizeof(domains[0]) + sizeof(int) + sizeof(domainSubscribers[0]));
+     if (size != expected) {
+         printf("Snapshot %s is truncated\n", path);
+         unmapFile(data, size);
+         return -1;
+     }
+     
+     char *cursor = data + sizeof(SnapshotHeader);
+     
+     // Nothing is copied into the registries unless the whole image is valid
+     if (validateSnapshot(header, cursor) != 0) {
+         printf("Snapshot %s is corrupt\n", path);
+         unmapFile(data, size);
+         return -1;
+     }
+     
+     snapshotGeneration = header->generation;
+     clearConflationTables();
+     resetMetrics();
+     eventBus.subscriberCount = header->subscriberCount;
+     for (int i = 0; i < header->subscriberCount; i++) {
+         SnapshotSubscriber *record = (SnapshotSubscriber *)cursor;
+         Subscriber *subscriber = &eventBus.subscribers[i];
+         strcpy(subscriber->id, record->id);
+         memcpy(subscriber->eventTypes, record->eventTypes, sizeof(subscriber->eventTypes));
+         subscriber->eventTypeCount = record->eventTypeCount;
+         subscriber->handler = findHandler(record->handlerName);
+         subscriber->conflationTable = -1;
+         subscriber->slowViolations = 0;
+         subscriber->throttleRemaining = 0;
+         subscriber->flaggedSlow = 0;
+         subscriber->detached = 0;
+         if (subscriber->handler == NULL) {
+             printf("Subscriber %s has unknown handler %s, clearing its subscriptions\n", 
+                    record->id, record->handlerName);
+             subscriber->eventTypeCount = 0;
+         }
+         if (record->conflated && conflationTableCount < MAX_CONFLATED_SUBSCRIBERS) {
+             memset(&conflationTables[conflationTableCount], 0, sizeof(ConflationTable));
+             subscriber->conflationTable = conflationTableCount++;
+         }
+         cursor += sizeof(SnapshotSubscriber);
+     }
+     
+     newsAgencyCount = header->newsAgencyCount;
+     memcpy(newsAgencies, cursor, newsAgencyCount * sizeof(NewsAgency));
+     cursor += newsAgencyCount * sizeof(NewsAgency);
+     
+     peopleCount = header->peopleCount;
+     for (int i = 0; i < peopleCount; i++) {
+         SnapshotPerson *record = (SnapshotPerson *)cursor;
+         strcpy(people[i].id, record->id);
+         memcpy(people[i].interestedDomains, record->interestedDomains, sizeof(people[i].interestedDomains));
+         people[i].domainCount = record->domainCount;
+         people[i].domainMask = record->domainMask;
+         people[i].inboxHead = 0;
+         people[i].inboxCount = 0;
+         people[i].inboxDropped = 0;
+         cursor += sizeof(SnapshotPerson);
      }
      
-     // Remove this domain by shifting the remaining ones
-     for (int i = domainFound; i < people[personIndex].domainCount - 1; i++) {
-         strcpy(people[personIndex].interestedDomains[i], people[personIndex].interestedDomains[i + 1]);
+     domainCount = header->domainCount;
+     memcpy(domains, cursor, domainCount * sizeof(domains[0]));
+     cursor += domainCount * sizeof(domains[0]);
+     memcpy(domainSubscriberCounts, cursor, domainCount * sizeof(int));
+     cursor += domainCount * sizeof(int);
+     memcpy(domainSubscribers, cursor, domainCount * sizeof(domainSubscribers[0]));
+     
+     printf("Snapshot loaded from %s: %d subscribers, %d agencies, %d people, %d domains\n", 
+            path, eventBus.subscriberCount, newsAgencyCount, peopleCount, domainCount);
+     unmapFile(data, size);
+     return 0;
+ }
+ 
+ /**
+  * Apply the changes recorded in a delta journal
+  * 
+  * @param path - Journal file
+  * @return - Number of changes applied
+  */
+ int replayJournal(const char *path) {
+     FILE *file = fopen(path, "rb");
+     if (file == NULL) {
+         return 0;
      }
-     people[personIndex].domainCount--;
      
-     // Also unsubscribe this person from the EventBus for this domain
-     char subscriberId[MAX_ID_LENGTH];
-     sprintf(subscriberId, "Person_%s", people[personIndex].id);
-     unsubscribe(subscriberId, domain);
+     // Records only apply on top of the snapshot they were journaled after
+     JournalHeader header;
+     if (fread(&header, sizeof(header), 1, file) != 1 || 
+         memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 || 
+         header.version != JOURNAL_VERSION || header.generation != snapshotGeneration) {
+         printf("Journal %s does not belong to the loaded snapshot, ignoring it\n", path);
+         fclose(file);
+         return 0;
+     }
      
-     printf("Person %s unsubscribed from domain: %s\n", people[personIndex].id, domain);
+     JournalRecord record;
+     int applied = 0;
+     journalReplaying = 1;
+     while (fread(&record, sizeof(record), 1, file) == 1) {
+         if (!isTerminated(record.id, sizeof(record.id)) || !isTerminated(record.name, sizeof(record.name)) || 
+             !isTerminated(record.handlerName, sizeof(record.handlerName))) {
+             printf("Journal %s has a corrupt record, stopping replay\n", path);
+             break;
+         }
+         switch (record.op) {
+         case JOURNAL_SUBSCRIBE:
+             if (findHandler(record.handlerName) != NULL) {
+                 subscribe(record.id, record.name, findHandler(record.handlerName));
+             }
+             break;
+         case JOURNAL_UNSUBSCRIBE:
+             unsubscribe(record.id, record.name);
+             break;
+         case JOURNAL_ENABLE_CONFLATION:
+             enableConflation(record.id);
+             break;
+         case JOURNAL_REGISTER_AGENCY:
+             registerNewsAgency(record.id);
+             break;
+         case JOURNAL_ADD_AGENCY_DOMAIN:
+             addDomainToAgency(record.index, record.name);
+             break;
+         case JOURNAL_REGISTER_PERSON:
+             registerPerson(record.id);
+             break;
+         case JOURNAL_PERSON_SUBSCRIBE:
+             personSubscribeToDomain(record.index, record.name);
+             break;
+         case JOURNAL_PERSON_UNSUBSCRIBE:
+             personUnsubscribeFromDomain(record.index, record.name);
+             break;
+         }
+         applied++;
+     }
+     journalReplaying = 0;
+     fclose(file);
+     
+     printf("Replayed %d journal records from %s\n", applied, path);
+     return applied;
  }
  
- // The function comment below was in the original code but the function was missing
- // Handle news events for people
+ /**
+  * Start recording registry changes to a delta journal
+  * A journal of the current snapshot generation is appended to, any other one is restarted
+  * 
+  * @param path - Journal file
+  * @return - 0 on success, -1 if failed
+  */
+ int openJournal(const char *path) {
+     snprintf(openJournalPath, sizeof(openJournalPath), "%s", path);
+     
+     FILE *file = fopen(path, "rb");
+     if (file != NULL) {
+         JournalHeader header;
+         int current = fread(&header, sizeof(header), 1, file) == 1 && 
+                       memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) == 0 && 
+                       header.version == JOURNAL_VERSION && header.generation == snapshotGeneration;
+         fclose(file);
+         if (current) {
+             journalFile = fopen(path, "ab");
+             if (journalFile == NULL) {
+                 perror("Error opening journal");
+                 return -1;
+             }
+             return 0;
+         }
+     }
+     return startJournal(path);
+ }
  
+ /**
+  * Restore the registries from a snapshot plus its journal, then keep journaling
+  * 
+  * @param snapshotPath - Snapshot file
+  * @param journalPath - Journal file
+  * @return - 0 if a snapshot was loaded, -1 otherwise
+  */
+ int restoreState(const char *snapshotPath, const char *journalPath) {
+     int result = loadSnapshot(snapshotPath);
+     if (result == 0) {
+         replayJournal(journalPath);
+     }
+     openJournal(journalPath);
+     return result;
+ }
  
  /**
-  * Publish news from a news agency to interested subscribers
+  * Restart from the last snapshot and journal instead of registering everything again
   * 
-  * @param agencyIndex - Index of the publishing agency
-  * @param domain - Domain/category of the news
-  * @param content - The actual news content
+  * @return - Process exit code
   */
- void publishNews(int agencyIndex, char *domain, char *content) {
-     if (agencyIndex < 0 || agencyIndex >= newsAgencyCount) {
-         printf("Invalid agency index!\n");
-         return;
+ int runRestored() {
+     if (restoreState(SNAPSHOT_PATH, JOURNAL_PATH) != 0) {
+         printf("No usable snapshot, run without --restore first\n");
+         return 1;
      }
      
-     // Check if agency is authorized to publish in this domain
-     int domainFound = 0;
-     for (int i = 0; i < newsAgencies[agencyIndex].domainCount; i++) {
-         if (strcmp(newsAgencies[agencyIndex].domains[i], domain) == 0) {
-             domainFound = 1;
+     printf("\n--- Simulating Sensor Readings ---\n");
+     simulateSensorReading("Temperature", "TemperatureSensorTimisoara");
+     simulateSensorReading("WaterLevel", "WaterLevelSensorArad");
+     dispatchEvents(0);
+     drainConflatedEvents();
+     
+     printf("\n--- Publishing News ---\n");
+     for (int i = 0; i < newsAgencyCount; i++) {
+         publishNews(i, newsAgencies[i].domains[0], "News published after a restart");
+     }
+     deliverNewsDigests(personDigestHandler);
+     return 0;
+ }
+ 
+ #ifdef __linux__
+ /**
+  * Map an existing shared event bus, waiting a bounded time for its creator to finish
+  * 
+  * @param fd - Open descriptor of the shared memory object
+  * @param name - Name of the shared memory object
+  * @return - Pointer to the mapped bus, or NULL if the object is stale or from another build
+  */
+ SharedEventBus *attachSharedEventBus(int fd, const char *name) {
+     long long deadline = currentTimeNs() + SHARED_ATTACH_TIMEOUT_MS * 1000000LL;
+     struct stat st;
+     
+     // The creator sizes the object right after creating it
+     for (;;) {
+         if (fstat(fd, &st) == -1) {
+             perror("Error reading shared event bus");
+             return NULL;
+         }
+         if (st.st_size != 0 || currentTimeNs() >= deadline) {
              break;
          }
+         usleep(1000);
+     }
+     if (st.st_size != (off_t)sizeof(SharedEventBus)) {
+         printf("Shared event bus %s has an unexpected size, run with --shm-reset\n", name);
+         return NULL;
      }
      
-     if (!domainFound) {
-         printf("Agency %s does not publish in domain: %s\n", 
-                newsAgencies[agencyIndex].id, domain);
-         return;
+     SharedEventBus *bus = mmap(NULL, sizeof(SharedEventBus), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+     if (bus == MAP_FAILED) {
+         perror("mmap");
+         return NULL;
      }
      
-     // Create news object
-     News *news = malloc(sizeof(News));
-     strcpy(news->domain, domain);
-     strcpy(news->content, content);
-     strcpy(news->agency, newsAgencies[agencyIndex].id);
-     news->timestamp = time(NULL);
+     while (atomic_load(&bus->magic) != SHARED_BUS_MAGIC && currentTimeNs() < deadline) {
+         usleep(1000);
+     }
+     if (atomic_load(&bus->magic) != SHARED_BUS_MAGIC || 
+         bus->version != SHARED_BUS_VERSION || bus->layoutSize != sizeof(SharedEventBus)) {
+         printf("Shared event bus %s is stale or from another build, run with --shm-reset\n", name);
+         munmap(bus, sizeof(SharedEventBus));
+         return NULL;
+     }
+     return bus;
+ }
+ 
+ /**
+  * Map the shared event bus, creating and initializing it if it does not exist yet
+  * 
+  * @param name - Name of the shared memory object (e.g., SHARED_BUS_NAME)
+  * @return - Pointer to the mapped bus, or NULL if failed
+  */
+ SharedEventBus *openSharedEventBus(const char *name) {
+     for (int attempt = 0; attempt < SHARED_ATTACH_RETRIES; attempt++) {
+         int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+         if (fd != -1) {
+             if (ftruncate(fd, sizeof(SharedEventBus)) == -1) {
+                 perror("ftruncate");
+                 close(fd);
+                 shm_unlink(name);
+                 return NULL;
+             }
+             SharedEventBus *bus = mmap(NULL, sizeof(SharedEventBus), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+             close(fd);
+             if (bus == MAP_FAILED) {
+                 perror("mmap");
+                 shm_unlink(name);
+                 return NULL;
+             }
+             
+             // ftruncate zero-fills the object, which is a valid empty bus
+             bus->version = SHARED_BUS_VERSION;
+             bus->layoutSize = sizeof(SharedEventBus);
+             atomic_store(&bus->attached, 1);
+             atomic_store(&bus->magic, SHARED_BUS_MAGIC);
+             printf("Shared event bus %s created\n", name);
+             return bus;
+         }
+         if (errno != EEXIST) {
+             perror("shm_open");
+             return NULL;
+         }
+         
+         fd = shm_open(name, O_RDWR, 0600);
+         if (fd == -1) {
+             continue; // Unlinked in the meantime, try to create it
+         }
+         SharedEventBus *bus = attachSharedEventBus(fd, name);
+         close(fd);
+         if (bus == NULL) {
+             return NULL;
+         }
+         
+         // A count of zero means the last process is detaching and unlinking it
+         if (atomic_fetch_add(&bus->attached, 1) == 0) {
+             atomic_fetch_sub(&bus->attached, 1);
+             munmap(bus, sizeof(SharedEventBus));
+             usleep(1000);
+             continue;
+         }
+         printf("Shared event bus %s attached\n", name);
+         return bus;
+     }
      
-     // Publish event with domain as the event type
-     publish(domain, news, newsAgencies[agencyIndex].id);
+     printf("Could not attach to shared event bus %s\n", name);
+     return NULL;
  }
  
  /**
-  * Generate realistic random sensor data based on sensor type
+  * Unmap the shared event bus from this process, removing it when no process uses it anymore
+  * Processes that crash never detach; use resetSharedEventBus to clean up after them
   * 
-  * @param sensorType - Type of the sensor (e.g., "Temperature", "WaterLevel")
-  * @return - Random value appropriate for the sensor type
+  * @param bus - Bus returned by openSharedEventBus
+  * @param name - Name the bus was opened with
   */
- float generateSensorData(char *sensorType) {
-     float value;
+ void closeSharedEventBus(SharedEventBus *bus, const char *name) {
+     int last = atomic_fetch_sub(&bus->attached, 1) == 1;
+     munmap(bus, sizeof(SharedEventBus));
+     if (last) {
+         shm_unlink(name);
+     }
+ }
+ 
+ /**
+  * Remove the shared event bus, including any subscribers left by crashed processes
+  * Processes still attached keep their mapping; new processes get a fresh bus
+  * 
+  * @param name - Name of the shared memory object
+  * @return - Process exit code
+  */
+ int resetSharedEventBus(const char *name) {
+     if (shm_unlink(name) == -1 && errno != ENOENT) {
+         perror("shm_unlink");
+         return 1;
+     }
+     printf("Shared event bus %s removed\n", name);
+     return 0;
+ }
+ 
+ /**
+  * Acquire the subscriber table lock (only used on the subscription path)
+  */
+ void lockSharedTable(SharedEventBus *bus) {
+     while (atomic_exchange_explicit(&bus->tableLock, 1, memory_order_acquire)) {
+         sched_yield();
+     }
+ }
+ 
+ /**
+  * Release the subscriber table lock
+  */
+ void unlockSharedTable(SharedEventBus *bus) {
+     atomic_store_explicit(&bus->tableLock, 0, memory_order_release);
+ }
+ 
+ /**
+  * Register a subscriber for an event type on the shared bus
+  * If the subscriber already exists, adds the new event type to their interests
+  * 
+  * @param bus - The shared bus
+  * @param subscriberId - Unique ID for the subscriber
+  * @param eventType - Event type to subscribe to
+  * @return - Index of the subscriber in the shared table, or -1 if failed
+  */
+ int sharedSubscribe(SharedEventBus *bus, char *subscriberId, char *eventType) {
+     int freeSlot = -1;
      
-     if (strcmp(sensorType, "Temperature") == 0) {
-         value = 15.0 + ((float)rand() / RAND_MAX) * 25.0; // 15-40°C
-     } else if (strcmp(sensorType, "WaterLevel") == 0) {
-         value = ((float)rand() / RAND_MAX) * 10.0; // 0-10m
-     } else if (strcmp(sensorType, "Humidity") == 0) {
-         value = 30.0 + ((float)rand() / RAND_MAX) * 70.0; // 30-100%
-     } else {
-         value = ((float)rand() / RAND_MAX) * 100.0; // Generic 0-100
+     lockSharedTable(bus);
+     for (int i = 0; i < MAX_SHARED_SUBSCRIBERS; i++) {
+         SharedSubscriber *sub = &bus->subscribers[i];
+         if (!atomic_load(&sub->active)) {
+             if (freeSlot == -1) {
+                 freeSlot = i;
+             }
+             continue;
+         }
+         if (strcmp(sub->id, subscriberId) != 0) {
+             continue;
+         }
+         
+         // Subscriber exists, add the event type if not already subscribed
+         int typeCount = atomic_load_explicit(&sub->eventTypeCount, memory_order_relaxed);
+         for (int j = 0; j < typeCount; j++) {
+             if (strcmp(sub->eventTypes[j], eventType) == 0) {
+                 unlockSharedTable(bus);
+                 printf("Shared subscriber %s already subscribed to %s\n", subscriberId, eventType);
+                 return i;
+             }
+         }
+         if (typeCount >= MAX_EVENT_TYPES) {
+             unlockSharedTable(bus);
+             printf("Max event types reached for shared subscriber %s\n", subscriberId);
+             return -1;
+         }
+         // Publishers read the types without the lock, so the string must land before the count
+         strcpy(sub->eventTypes[typeCount], eventType);
+         atomic_store_explicit(&sub->eventTypeCount, typeCount + 1, memory_order_release);
+         unlockSharedTable(bus);
+         printf("Shared subscriber %s subscribed to additional event type: %s\n", subscriberId, eventType);
+         return i;
      }
      
-     return value;
+     if (freeSlot == -1) {
+         unlockSharedTable(bus);
+         printf("Max shared subscribers reached!\n");
+         return -1;
+     }
+     
+     // New subscriber starts reading at the current end of the ring
+     SharedSubscriber *sub = &bus->subscribers[freeSlot];
+     sub->pid = getpid();
+     strcpy(sub->id, subscriberId);
+     strcpy(sub->eventTypes[0], eventType);
+     atomic_store_explicit(&sub->eventTypeCount, 1, memory_order_release);
+     atomic_store(&sub->cursor, atomic_load(&bus->tail));
+     atomic_store(&sub->active, 1);
+     unlockSharedTable(bus);
+     
+     printf("New shared subscriber %s registered for event type: %s\n", subscriberId, eventType);
+     return freeSlot;
  }
  
  /**
-  * Simulate a sensor reading and publish it to the event bus
+  * Detach a subscriber from the shared bus, so it no longer holds back publishers
   * 
-  * @param sensorType - Type of the sensor
-  * @param sensorId - Unique ID for the sensor
+  * @param bus - The shared bus
+  * @param subscriberIndex - Index returned by sharedSubscribe
   */
- void simulateSensorReading(char *sensorType, char *sensorId) {
-     float *data = malloc(sizeof(float));
-     *data = generateSensorData(sensorType);
-     publish(sensorType, data, sensorId);
+ void sharedUnsubscribe(SharedEventBus *bus, int subscriberIndex) {
+     lockSharedTable(bus);
+     atomic_store(&bus->subscribers[subscriberIndex].active, 0);
+     unlockSharedTable(bus);
+     printf("Shared subscriber %s detached\n", bus->subscribers[subscriberIndex].id);
  }
  
  /**
-  * Event handler for displaying numeric sensor values
-  * Simply displays the raw value from the sensor
+  * Check whether a shared subscriber listens for an event type
+  */
+ int sharedSubscriberWants(SharedSubscriber *sub, const char *eventType) {
+     int typeCount = atomic_load_explicit(&sub->eventTypeCount, memory_order_acquire);
+     for (int j = 0; j < typeCount; j++) {
+         if (strcmp(sub->eventTypes[j], eventType) == 0) {
+             return 1;
+         }
+     }
+     return 0;
+ }
+ 
+ /**
+  * Find the cursor of the slowest attached subscriber and whether anyone wants an event type
   * 
-  * @param event - The sensor event that was received
+  * @param bus - The shared bus
+  * @param eventType - Event type being published
+  * @param tail - Current tail, returned when no subscriber is attached
+  * @param interested - Set to 1 if some subscriber listens for eventType
+  * @return - Lowest cursor among attached subscribers
   */
- void numericDisplayHandler(Event *event) {
-     float *value = (float *)event->data;
-     printf("[NumericDisplay] Value from %s: %.2f\n", event->sourceId, *value);
+ uint64_t sharedMinCursor(SharedEventBus *bus, const char *eventType, uint64_t tail, int *interested) {
+     uint64_t min = tail;
+     *interested = 0;
+     
+     for (int i = 0; i < MAX_SHARED_SUBSCRIBERS; i++) {
+         SharedSubscriber *sub = &bus->subscribers[i];
+         if (!atomic_load_explicit(&sub->active, memory_order_acquire)) {
+             continue;
+         }
+         uint64_t cursor = atomic_load_explicit(&sub->cursor, memory_order_acquire);
+         if (cursor < min) {
+             min = cursor;
+         }
+         if (sharedSubscriberWants(sub, eventType)) {
+             *interested = 1;
+         }
+     }
+     return min;
  }
  
  /**
-  * Event handler for tracking and displaying maximum sensor values
-  * Keeps track of maximum values seen for each sensor type
+  * Detach subscribers whose owning process has exited
+  * Only called when the ring is full, so kill() stays off the fast path
   * 
-  * @param event - The sensor event that was received
+  * @return - Number of subscribers detached
   */
- void maxValueDisplayHandler(Event *event) {
-     // Static variables retain their values between function calls
-     static float maxTemp = -999.9, maxHumidity = -999.9, maxWater = -999.9;
-     float *value = (float *)event->data;
+ int reapDeadSharedSubscribers(SharedEventBus *bus) {
+     int reaped = 0;
+     
+     lockSharedTable(bus);
+     for (int i = 0; i < MAX_SHARED_SUBSCRIBERS; i++) {
+         SharedSubscriber *sub = &bus->subscribers[i];
+         if (atomic_load(&sub->active) && kill(sub->pid, 0) == -1 && errno == ESRCH) {
+             atomic_store(&sub->active, 0);
+             printf("Shared subscriber %s (pid %d) is gone, detaching\n", sub->id, (int)sub->pid);
+             reaped++;
+         }
+     }
+     unlockSharedTable(bus);
+     return reaped;
+ }
  
-     printf("[MaxValueDisplay] Received %s: %.2f from %s\n", event->type, *value, event->sourceId);
+ /**
+  * Publish an event to subscribers in any process attached to the shared bus
+  * The payload is copied into the ring; no system call is made unless a subscriber is asleep
+  * 
+  * @param bus - The shared bus
+  * @param eventType - Type of event being published
+  * @param payload - Event data to copy into the ring
+  * @param payloadSize - Size of the event data in bytes
+  * @param sourceId - ID of the publisher
+  * @return - 1 if published, 0 if nobody listens for eventType, -1 if failed
+  */
+ int sharedPublish(SharedEventBus *bus, char *eventType, const void *payload, uint32_t payloadSize, char *sourceId) {
+     if (payloadSize > SHARED_PAYLOAD_SIZE) {
+         printf("Payload of %u bytes too large for the shared bus\n", payloadSize);
+         return -1;
+     }
+     
+     // Claim the next slot, as long as every subscriber has read the event it would overwrite
+     uint64_t pos;
+     int interested;
+     int reaped = 0;
+     for (;;) {
+         pos = atomic_load_explicit(&bus->tail, memory_order_relaxed);
+         uint64_t min = sharedMinCursor(bus, eventType, pos, &interested);
+         if (!interested) {
+             return 0;
+         }
+         if (pos - min >= SHARED_RING_CAPACITY) {
+             if (!reaped && reapDeadSharedSubscribers(bus) > 0) {
+                 reaped = 1;
+                 continue;
+             }
+             atomic_fetch_add(&bus->dropped, 1);
+             return -1;
+         }
+         if (atomic_compare_exchange_weak(&bus->tail, &pos, pos + 1)) {
+             break;
+         }
+     }
+     
+     SharedEventSlot *slot = &bus->slots[pos % SHARED_RING_CAPACITY];
+     strcpy(slot->type, eventType);
+     strcpy(slot->sourceId, sourceId);
+     slot->payloadSize = payloadSize;
+     memcpy(slot->payload, payload, payloadSize);
+     atomic_store(&slot->sequence, pos + 1);
+     
+     // Wake sleeping subscribers only if there are any
+     if (atomic_load(&bus->waiters) > 0) {
+         atomic_fetch_add(&bus->notify, 1);
+         syscall(SYS_futex, &bus->notify, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+     }
+     return 1;
+ }
  
-     // Update maximum values if new value is higher
-     if (strcmp(event->type, "Temperature") == 0 && *value > maxTemp) {
-         maxTemp = *value;
-         printf("[MaxValueDisplay] New max temperature: %.2f from %s\n", maxTemp, event->sourceId);
-     } else if (strcmp(event->type, "Humidity") == 0 && *value > maxHumidity) {
-         maxHumidity = *value;
-         printf("[MaxValueDisplay] New max humidity: %.2f from %s\n", maxHumidity, event->sourceId);
-     } else if (strcmp(event->type, "WaterLevel") == 0 && *value > maxWater) {
-         maxWater = *value;
-         printf("[MaxValueDisplay] New max water level: %.2f from %s\n", maxWater, event->sourceId);
+ /**
+  * Deliver the events waiting for a shared subscriber, sleeping if there are none
+  * The handler receives an Event whose data points at the inline payload in the ring,
+  * valid only for the duration of the call
+  * 
+  * @param bus - The shared bus
+  * @param subscriberIndex - Index returned by sharedSubscribe
+  * @param handler - Function to call for each matching event
+  * @param timeoutMs - Maximum time to sleep when the ring is empty
+  * @return - Number of events delivered to the handler
+  */
+ int sharedPoll(SharedEventBus *bus, int subscriberIndex, EventHandler handler, int timeoutMs) {
+     SharedSubscriber *sub = &bus->subscribers[subscriberIndex];
+     long long deadline = currentTimeNs() + timeoutMs * 1000000LL;
+     int delivered = 0;
+     int spins = 0;
+     
+     for (;;) {
+         uint64_t cursor = atomic_load_explicit(&sub->cursor, memory_order_relaxed);
+         SharedEventSlot *slot = &bus->slots[cursor % SHARED_RING_CAPACITY];
+         
+         if (atomic_load_explicit(&slot->sequence, memory_order_acquire) == cursor + 1) {
+             if (sharedSubscriberWants(sub, slot->type)) {
+                 Event event;
+                 strcpy(event.type, slot->type);
+                 strcpy(event.sourceId, slot->sourceId);
+                 event.data = slot->payload;
+                 event.retain = NULL;
+                 event.release = NULL;
+                 handler(&event);
+                 delivered++;
+             }
+             // Releasing the slot lets publishers reuse it
+             atomic_store_explicit(&sub->cursor, cursor + 1, memory_order_release);
+             spins = 0;
+             continue;
+         }
+         
+         if (delivered > 0) {
+             return delivered;
+         }
+         if (++spins < SHARED_SPIN_COUNT) {
+             continue;
+         }
+         
+         long long remaining = deadline - currentTimeNs();
+         if (remaining <= 0) {
+             return 0;
+         }
+         
+         // Nothing to read: announce ourselves as a waiter, then re-check before sleeping
+         atomic_fetch_add(&bus->waiters, 1);
+         uint32_t seen = atomic_load(&bus->notify);
+         if (atomic_load(&slot->sequence) != cursor + 1) {
+             struct timespec timeout = { remaining / 1000000000LL, remaining % 1000000000LL };
+             syscall(SYS_futex, &bus->notify, FUTEX_WAIT, seen, &timeout, NULL, 0);
+         }
+         atomic_fetch_sub(&bus->waiters, 1);
+         spins = 0;
      }
  }
  
  /**
-  * Event handler for displaying formatted text about sensor readings
-  * Presents sensor data in a more descriptive format
+  * Run a numeric display in this process, fed by sensors in other processes
+  * Exits after SHARED_IDLE_TIMEOUT_MS without events
   * 
-  * @param event - The sensor event that was received
+  * @return - Process exit code
   */
- void textDisplayHandler(Event *event) {
-     float *value = (float *)event->data;
-     printf("[TextDisplay] %s reported a %s value of %.2f\n", event->sourceId, event->type, *value);
+ int runSharedDisplay() {
+     SharedEventBus *bus = openSharedEventBus(SHARED_BUS_NAME);
+     if (bus == NULL) {
+         return 1;
+     }
+     
+     int index = sharedSubscribe(bus, "SharedNumericDisplay", "Temperature");
+     sharedSubscribe(bus, "SharedNumericDisplay", "WaterLevel");
+     sharedSubscribe(bus, "SharedNumericDisplay", "Humidity");
+     if (index == -1) {
+         closeSharedEventBus(bus, SHARED_BUS_NAME);
+         return 1;
+     }
+     
+     int total = 0;
+     int received;
+     while ((received = sharedPoll(bus, index, numericDisplayHandler, SHARED_IDLE_TIMEOUT_MS)) > 0) {
+         total += received;
+     }
+     
+     printf("Shared display received %d events, publishers dropped %llu\n", 
+            total, (unsigned long long)atomic_load(&bus->dropped));
+     sharedUnsubscribe(bus, index);
+     closeSharedEventBus(bus, SHARED_BUS_NAME);
+     return 0;
+ }
+ 
+ /**
+  * Publish simulated sensor readings to displays in other processes
+  * 
+  * @return - Process exit code
+  */
+ int runSharedSensors() {
+     SharedEventBus *bus = openSharedEventBus(SHARED_BUS_NAME);
+     if (bus == NULL) {
+         return 1;
+     }
+     
+     char *sensors[][2] = {
+         {"Temperature", "TemperatureSensorTimisoara"},
+         {"Temperature", "TemperatureSensorArad"},
+         {"WaterLevel", "WaterLevelSensorTimisoara"},
+         {"WaterLevel", "WaterLevelSensorArad"},
+         {"Humidity", "HumiditySensorTimisoara"},
+         {"Humidity", "HumiditySensorArad"}
+     };
+     
+     int published = 0;
+     for (int i = 0; i < 6; i++) {
+         float value = generateSensorData(sensors[i][0]);
+         if (sharedPublish(bus, sensors[i][0], &value, sizeof(value), sensors[i][1]) == 1) {
+             published++;
+         }
+     }
+     
+     printf("Published %d sensor readings on the shared bus\n", published);
+     closeSharedEventBus(bus, SHARED_BUS_NAME);
+     return 0;
  }
+ #endif
  
  /**
   * Main function - Entry point of the program
   * Sets up the event bus, subscribers, simulates sensors, and demonstrates the news system
   */
- int main() {
+ int main(int argc, char *argv[]) {
      initEventBus();
      
+     // Name the handlers so subscriptions can be saved in snapshots
+     registerHandler("numericDisplayHandler", numericDisplayHandler);
+     registerHandler("maxValueDisplayHandler", maxValueDisplayHandler);
+     registerHandler("textDisplayHandler", textDisplayHandler);
+     
+     // Flag displays whose handler takes over 1 ms for 3 events in a row
+     setSlowConsumerPolicy(SLOW_POLICY_FLAG, 1000, 3);
+     
+     if (argc > 1 && strcmp(argv[1], "--restore") == 0) {
+         return runRestored();
+     }
+     
+     // Cross-process mode: run only a shared-memory display or sensor publisher
+ #ifdef __linux__
+     if (argc > 1 && strcmp(argv[1], "--shm-display") == 0) {
+         return runSharedDisplay();
+     }
+     if (argc > 1 && strcmp(argv[1], "--shm-sensors") == 0) {
+         return runSharedSensors();
+     }
+     if (argc > 1 && strcmp(argv[1], "--shm-reset") == 0) {
+         return resetSharedEventBus(SHARED_BUS_NAME);
+     }
+ #endif
+     
      // Register display subscribers for various sensor types
-     subscribe("NumericDisplay1", "Temperature", numericDisplayHandler);
-     subscribe("NumericDisplay1", "Humidity", numericDisplayHandler);
-     subscribe("NumericDisplay1", "WaterLevel", numericDisplayHandler);
+     // The numeric display only shows the latest value of each sensor
+     subscribeConflated("NumericDisplay1", "Temperature", numericDisplayHandler);
+     subscribeConflated("NumericDisplay1", "Humidity", numericDisplayHandler);
+     subscribeConflated("NumericDisplay1", "WaterLevel", numericDisplayHandler);
      subscribe("MaxValueDisplay1", "Temperature", maxValueDisplayHandler);
      subscribe("MaxValueDisplay1", "WaterLevel", maxValueDisplayHandler);
      subscribe("MaxValueDisplay1", "Humidity", maxValueDisplayHandler);
@@ -527,6 +2911,23 @@
      simulateSensorReading("Humidity", "HumiditySensorTimisoara");
      simulateSensorReading("Humidity", "HumiditySensorArad");
      
+     // Deliver the queued readings, water level alarms first
+     printf("\n--- Dispatching Sensor Readings ---\n");
+     dispatchEvents(0);
+     drainConflatedEvents();
+     printLaneStatistics();
+     
+     // A burst of readings: the numeric display catches up with one value per sensor
+     printf("\n--- Simulating Sensor Burst ---\n");
+     for (int round = 0; round < 3; round++) {
+         simulateSensorReading("Temperature", "TemperatureSensorTimisoara");
+         simulateSensorReading("Temperature", "TemperatureSensorArad");
+         simulateSensorReading("WaterLevel", "WaterLevelSensorTimisoara");
+     }
+     dispatchEvents(0);
+     drainConflatedEvents();
+     printConflationStatistics();
+     
      // Create news agencies and specify their domains
      printf("\n--- Setting up News Agencies ---\n");
      int bbcIndex = registerNewsAgency("BBC");
@@ -561,6 +2962,12 @@
      publishNews(cnnIndex, "Business", "Stock market reaches all-time high");
      publishNews(espnIndex, "Sports", "Local team wins championship");
      publishNews(bbcIndex, "Culture", "New museum exhibition opens next week");
+     deliverNewsDigests(personDigestHandler);
+     
+     // Save the registries; later changes go to the journal until the next snapshot
+     printf("\n--- Saving Snapshot ---\n");
+     openJournal(JOURNAL_PATH);
+     saveSnapshot(SNAPSHOT_PATH);
      
      // Demonstrate subscription changes
      printf("\n--- Updating Subscriptions ---\n");
@@ -571,6 +2978,13 @@
      printf("\n--- Publishing More News ---\n");
      publishNews(bbcIndex, "Sports", "Tennis tournament final results");
      publishNews(cnnIndex, "Business", "New economic forecast released");
+     deliverNewsDigests(personDigestHandler);
+     
+     // Dump per-subscriber and per-topic dispatch metrics
+     printf("\n--- Event Bus Metrics ---\n");
+     static BusMetricsSnapshot metrics;
+     takeMetricsSnapshot(&metrics);
+     writeMetricsJson(&metrics, stdout);
      
      return 0;
  }
\ No newline at end of file